@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+
+/* IMA-ADPCM, shared with the host tool that encodes the soundtrack so both
+ * decode it the same way.
+ *
+ * Every 16-bit sample is a 4-bit code, two per byte with the first in the low
+ * nibble. Bit 3 of a code is the sign of the step taken from the previous
+ * sample, bits 0 to 2 its size in eighths of the current step. The step grows
+ * after large codes and shrinks after small ones. */
+
+#define ADPCM_STEP_COUNT 89U
+
+static uint16_t const adpcm_step[ADPCM_STEP_COUNT] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+/* Change of the step index after each code, by its size. */
+static int8_t const adpcm_step_change[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+/* Decoder state, a stream starts from {0, 0}. */
+typedef struct
+{
+    int16_t sample;
+    uint8_t step_i;
+} adpcm_st;
+
+/* Decodes `code` into the next sample of `state`. */
+static inline int16_t adpcm_decode(adpcm_st *const state, uint8_t const code)
+{
+    int32_t const step = adpcm_step[state->step_i];
+    int32_t delta = step >> 3;
+    if (code & 1U)
+    {
+        delta += step >> 2;
+    }
+    if (code & 2U)
+    {
+        delta += step >> 1;
+    }
+    if (code & 4U)
+    {
+        delta += step;
+    }
+    int32_t sample = state->sample + (code & 8U ? -delta : delta);
+    sample = sample > INT16_MAX ? INT16_MAX : sample;
+    sample = sample < INT16_MIN ? INT16_MIN : sample;
+    state->sample = (int16_t)sample;
+
+    int16_t const step_last = ADPCM_STEP_COUNT - 1U;
+    int16_t step_i = state->step_i + adpcm_step_change[code & 7U];
+    step_i = step_i < 0 ? 0 : step_i;
+    step_i = step_i > step_last ? step_last : step_i;
+    state->step_i = (uint8_t)step_i;
+    return state->sample;
+}
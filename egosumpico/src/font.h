@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+
+/* 3x5 matrix display font, shared with the host tool that rasterises it into
+ * the glyph atlas. */
+
+#define FONT_W 3U
+#define FONT_H 5U
+/* Largest scale in the atlas, a glyph row of `FONT_W * FONT_SCALE_MAX` pixels
+ * must fit in a byte. */
+#define FONT_SCALE_MAX 2U
+
+/* Every glyph is 15 bits, bit `i` is the pixel at column `i % 3` of row
+ * `i / 3`. Digits come first, then letters, then the symbols of
+ * `font_glyph_index`. */
+#define FONT_GLYPH_COUNT 43U
+static uint16_t const font_glyph[FONT_GLYPH_COUNT] = {
+    0x7B6F, /* 0 */
+    0x4926, /* 1 */
+    0x73E7, /* 2 */
+    0x79A7, /* 3 */
+    0x49ED, /* 4 */
+    0x79CF, /* 5 */
+    0x7BCF, /* 6 */
+    0x4927, /* 7 */
+    0x7BEF, /* 8 */
+    0x79EF, /* 9 */
+    0x5BEF, /* A */
+    0x7AEF, /* B */
+    0x724F, /* C */
+    0x3B6B, /* D */
+    0x72CF, /* E */
+    0x12CF, /* F */
+    0x7B4F, /* G */
+    0x5BED, /* H */
+    0x7497, /* I */
+    0x7B26, /* J */
+    0x5AED, /* K */
+    0x7249, /* L */
+    0x5B7D, /* M */
+    0x5B6F, /* N */
+    0x7B6F, /* O */
+    0x13EF, /* P */
+    0x4F6F, /* Q */
+    0x5AEF, /* R */
+    0x79CF, /* S */
+    0x2497, /* T */
+    0x7B6D, /* U */
+    0x176D, /* V */
+    0x5F6D, /* W */
+    0x5AAD, /* X */
+    0x24AD, /* Y */
+    0x72A7, /* Z */
+    0x0000, /* ' ' */
+    0x01C0, /* - */
+    0x05D0, /* + */
+    0x0410, /* : */
+    0x0E38, /* = */
+    0x2000, /* . */
+    0x2092, /* ! */
+};
+
+/* Glyph of `ch`, characters without one are drawn as a box. */
+static inline uint8_t font_glyph_index(char const ch)
+{
+    static char const symbol[] = " -+:=.!";
+    if (ch >= '0' && ch <= '9')
+    {
+        return (uint8_t)(ch - '0');
+    }
+    if (ch >= 'A' && ch <= 'Z')
+    {
+        return (uint8_t)(10 + ch - 'A');
+    }
+    for (uint8_t symbol_i = 0; symbol[symbol_i]; ++symbol_i)
+    {
+        if (ch == symbol[symbol_i])
+        {
+            return (uint8_t)(36 + symbol_i);
+        }
+    }
+    return 0;
+}
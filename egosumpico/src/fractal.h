@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Julia set kernels of the fractal effect. Plain C so that host tools can
+ * render the exact same frames as the demo. */
+
+#define FRACTAL_ITERATION_MAX 32U
+/* Size of the sample grid, every sample covers 2x2 pixels. */
+#define FRACTAL_W 80U
+#define FRACTAL_H 60U
+/* Range of `frame_rel` shown by the effect. */
+#define FRACTAL_FRAME_REL_FIRST 111U
+#define FRACTAL_FRAME_COUNT 132U
+
+/* Fraction bits of the fixed-point kernel. Up to 13 bits every product fits in
+ * 32 bits, above that 32x32->64 multiplies are used. */
+#ifndef FRACTAL_Q
+#define FRACTAL_Q 13
+#endif
+/* The grid steps take 5 bits off the fraction, and values up to 4 have to fit
+ * in 32 bits. */
+#if FRACTAL_Q < 5 || FRACTAL_Q > 28
+#error "FRACTAL_Q must be between 5 and 28."
+#endif
+
+#if FRACTAL_Q <= 13
+typedef int32_t fractal_wide_t;
+#else
+typedef int64_t fractal_wide_t;
+#endif
+
+static inline float fractal_imaginary_c(uint32_t const frame_rel)
+{
+    return 0.27f - (0.004f * frame_rel);
+}
+
+static inline int32_t fractal_to_fixed(float const val)
+{
+    return (int32_t)(val * (float)(1UL << FRACTAL_Q));
+}
+
+/* Iterations until the sample at grid coordinates `_y`, `_x` escapes, up to
+ * `iteration_max`. */
+static inline uint8_t fractal_iterate(float const imaginary_c, uint16_t const _y,
+                                      uint16_t const _x,
+                                      uint8_t const iteration_max)
+{
+    static float const real_c = -0.7f;
+    // static float const zoom = 1.2f;
+
+    /* Calculate the initial real and imaginary part of z, based on the pixel
+     * location and zoom and position values. */
+    float real_new = 1.5f * ((float)(_x * 2U) - (float)FRACTAL_W) /
+                     (96.0 /* zoom * VIDEO_W_2 */);
+    float imaginary_new =
+        ((float)(_y * 2U) - (float)FRACTAL_H) / (72.0 /* zoom * VIDEO_H_2 */);
+
+    uint8_t iteration;
+    for (iteration = 0; iteration < iteration_max; iteration++)
+    {
+        // Remember value of previous iteration.
+        float const real_old = real_new;
+        float const imaginary_old = imaginary_new;
+        // The actual iteration, the real and imaginary part are calculated.
+        real_new = real_old * real_old - imaginary_old * imaginary_old + real_c;
+        imaginary_new = 2.0f * real_old * imaginary_old + imaginary_c;
+        // If the point is outside the circle with radius 2: stop.
+        if ((real_new * real_new + imaginary_new * imaginary_new) > 1.5f)
+        {
+            break;
+        }
+    }
+    return iteration;
+}
+
+/* Same as `fractal_iterate` in fixed-point with `FRACTAL_Q` fraction bits,
+ * `imaginary_c` comes from `fractal_to_fixed`. The squares computed for the
+ * escape test are reused by the next iteration. */
+static inline uint8_t fractal_iterate_fixed(int32_t const imaginary_c,
+                                            uint16_t const _y,
+                                            uint16_t const _x,
+                                            uint8_t const iteration_max)
+{
+    int32_t const real_c = -(int32_t)((7LL << FRACTAL_Q) / 10);
+    fractal_wide_t const escape = (fractal_wide_t)3 << (FRACTAL_Q * 2 - 1);
+
+    /* 1.5 / 96 is 1 / 64 and the grid step is 2 pixels. */
+    int32_t real = ((int32_t)_x - (int32_t)(FRACTAL_W / 2)) *
+                   (int32_t)(1L << (FRACTAL_Q - 5));
+    int32_t imaginary =
+        (int32_t)(((int32_t)_y - (int32_t)(FRACTAL_H / 2)) *
+                  (int64_t)(1LL << (FRACTAL_Q + 1)) / 72);
+    fractal_wide_t real_sq = (fractal_wide_t)real * real;
+    fractal_wide_t imaginary_sq = (fractal_wide_t)imaginary * imaginary;
+
+    uint8_t iteration;
+    for (iteration = 0; iteration < iteration_max; iteration++)
+    {
+        fractal_wide_t const cross = (fractal_wide_t)real * imaginary;
+        real = (int32_t)((real_sq - imaginary_sq) >> FRACTAL_Q) + real_c;
+        imaginary = (int32_t)(cross >> (FRACTAL_Q - 1)) + imaginary_c;
+        real_sq = (fractal_wide_t)real * real;
+        imaginary_sq = (fractal_wide_t)imaginary * imaginary;
+        if (real_sq + imaginary_sq > escape)
+        {
+            break;
+        }
+    }
+    return iteration;
+}
@@ -3,6 +3,7 @@
 #include <string.h>
 
 #include "hardware/clocks.h"
+#include "hardware/divider.h"
 #include "hardware/vreg.h"
 #include "pico.h"
 #include "pico/audio_i2s.h"
@@ -13,7 +14,13 @@
 #include "pico/stdlib.h"
 #include "pico/sync.h"
 
-#include "../data/audio.h"
+#include "adpcm.h"
+#include "font.h"
+#include "fractal.h"
+#include "mesh.h"
+#include "plasma.h"
+#include "span.h"
+#include "sprite.h"
 
 #define vga_mode vga_mode_160x120_60
 #define VIDEO_W 160
@@ -21,6 +28,66 @@
 #define VIDEO_W_2 80
 #define VIDEO_H_2 60
 #define SAMPLES_PER_BUFFER 256
+/* Rows that drawing is ahead of composition. */
+#define DRAW_AHEAD 3
+
+/* Use the fixed-point Julia set kernel, see `FRACTAL_Q` for its precision. */
+#ifndef FRACTAL_FIXED_POINT
+#define FRACTAL_FIXED_POINT 1
+#endif
+/* How the fractal effect covers its sample grid. */
+#define FRACTAL_RENDER_BLOCK 0       /* Every sample, as the frame is drawn. */
+#define FRACTAL_RENDER_SUBDIVIDE 1   /* Mariani-Silver, by bands of rows. */
+#define FRACTAL_RENDER_PROGRESSIVE 2 /* A rotating subset of the samples. */
+#define FRACTAL_RENDER_STREAM 3      /* Frames rendered at build time. */
+#define FRACTAL_RENDER_BUDGET 4      /* Coarse, refined while time lasts. */
+#ifndef FRACTAL_RENDER
+#define FRACTAL_RENDER FRACTAL_RENDER_STREAM
+#endif
+/* Frames the progressive render takes to recompute every sample. */
+#ifndef FRACTAL_PHASES
+#define FRACTAL_PHASES 2
+#endif
+/* Time the budget render may spend on a frame, and the iterations of its
+ * coarse pass. */
+#ifndef FRACTAL_BUDGET_US
+#define FRACTAL_BUDGET_US 8000U
+#endif
+#ifndef FRACTAL_COARSE_ITERATIONS
+#define FRACTAL_COARSE_ITERATIONS 8U
+#endif
+/* Add the shadebob of the prototype over the fractal. */
+#ifndef FRACTAL_SHADEBOB
+#define FRACTAL_SHADEBOB 0
+#endif
+#if FRACTAL_PHASES != 1 && FRACTAL_PHASES != 2 && FRACTAL_PHASES != 4
+#error "FRACTAL_PHASES must be 1, 2 or 4."
+#endif
+#if FRACTAL_RENDER == FRACTAL_RENDER_STREAM
+#include "fractal_stream.h"
+#endif
+
+/* Integer plasma from the lookup tables in plasma_lut.h. */
+#ifndef PLASMA_FIXED_POINT
+#define PLASMA_FIXED_POINT 1
+#endif
+/* Pixels covered by a plasma sample along each axis. */
+#ifndef PLASMA_BLOCK
+#define PLASMA_BLOCK 4U
+#endif
+/* Blocks interpolated between their corner samples instead of flat. */
+#ifndef PLASMA_BILINEAR
+#define PLASMA_BILINEAR 0
+#endif
+#if VIDEO_W % PLASMA_BLOCK != 0 || VIDEO_H % PLASMA_BLOCK != 0
+#error "PLASMA_BLOCK must divide the screen size."
+#endif
+#include "plasma_lut.h"
+
+/* 3D shapes as flat shaded solids instead of wireframes. */
+#ifndef THREEDEE_FILLED
+#define THREEDEE_FILLED 0
+#endif
 
 static void frame_prologue();
 
@@ -37,6 +104,24 @@ typedef enum effect_e
     EFFECT_END,
 } effect_et;
 
+/* Lookup table for durations of each effect. */
+static uint32_t const effect_duration[EFFECT_END + 1] = {
+    10, 215, 131, 500, 280, 132, 360, 246, UINT32_MAX};
+/* Lookup table for the palette that will be used by each effect. */
+static uint8_t const effect_palette[EFFECT_END + 1] = {0, 1, 2, 1, 0,
+                                                       3, 4, 5, 3};
+
+/* First frame of `_effect`, frames count from 1. */
+static uint32_t effect_frame_first(effect_et const _effect)
+{
+    uint32_t frame_first = 1;
+    for (uint8_t effect_i = EFFECT_START; effect_i < _effect; ++effect_i)
+    {
+        frame_first += effect_duration[effect_i];
+    }
+    return frame_first;
+}
+
 static struct audio_buffer_pool *audio_buffer_pool;
 static bool frame_prologue_done; /* After frame ended, we prepared state for
                                     next frame. */
@@ -52,56 +137,202 @@ static effect_et effect = EFFECT_START;
 static uint8_t palette = 0;
 /* A palette with all colors used in the demo. */
 static uint16_t palette_list[6][255] = {};
+/* Rotation applied to the background colors of the current palette, this is
+ * how the color drift in WATER and ACID is done. */
+static uint8_t palette_offset = 0;
+/* Rotation of the previous frame. */
+static uint8_t palette_offset_prev = 0;
+/* The current palette as seen by the background, rotated by `palette_offset`.
+ * Rebuilt once per frame. */
+static uint16_t palette_bg[256] = {};
+/* The same at `palette_offset_prev`, for the rows drawn in the previous frame.
+ * Only rebuilt when the rotation moves. */
+static uint16_t palette_bg_prev[256] = {};
 /* The framebuf that will be written to screen. It is a composition of
- * backghround then foreground. */
-static uint16_t vid[VIDEO_H][VIDEO_W] = {};
-/* Hidden buffer that will be the background. */
-static uint8_t bg[VIDEO_H][VIDEO_W] = {};
+ * backghround then foreground, two pixels per word. */
+static uint16_t vid[VIDEO_H][VIDEO_W] __attribute__((aligned(4))) = {};
+/* Hidden buffer that will be the background. Rows are word aligned for the
+ * span generators. */
+static uint8_t bg[VIDEO_H][VIDEO_W] __attribute__((aligned(4))) = {};
 static uint8_t *const bg_idx = (uint8_t *const)bg;
-/* Hidden buffer that will be the foreground. */
-static uint8_t fg[VIDEO_H][VIDEO_W] = {};
-static uint8_t *const fg_idx = (uint8_t *const)fg;
-
-static int8_t const vertex_cube[][3][3] = {
-    {{0, 0, 0}, {0, 1, 0}, {1, 1, 0}}, {{0, 0, 0}, {1, 1, 0}, {1, 0, 0}},
-    {{1, 0, 0}, {1, 1, 0}, {1, 1, 1}}, {{1, 0, 0}, {1, 1, 1}, {1, 0, 1}},
-    {{1, 0, 1}, {1, 1, 1}, {0, 1, 1}}, {{1, 0, 1}, {0, 1, 1}, {0, 0, 1}},
-    {{0, 0, 1}, {0, 1, 1}, {0, 1, 0}}, {{0, 0, 1}, {0, 1, 0}, {0, 0, 0}},
-    {{0, 1, 0}, {0, 1, 1}, {1, 1, 1}}, {{0, 1, 0}, {1, 1, 1}, {1, 1, 0}},
-    {{1, 0, 1}, {0, 0, 1}, {0, 0, 0}}, {{1, 0, 1}, {0, 0, 0}, {1, 0, 0}},
+/* Hidden buffer that will be the foreground, two pixels per byte with the
+ * left one in the low nibble. A pixel is a level from 0 to `FG_LEVEL_MAX`
+ * that the ramp of the effect turns into a color. */
+static uint8_t fg[VIDEO_H][VIDEO_W / 2] __attribute__((aligned(4))) = {};
+#define FG_LEVEL_MAX 15U
+
+/* How the levels of fg map to the color of the effect, and how a fade
+ * treats them. */
+typedef enum
+{
+    /* Every two levels down halve the color, so a fade takes 2 levels off. */
+    FG_RAMP_HALVING,
+    /* Levels scale the color, a fade halves them. */
+    FG_RAMP_LINEAR,
+} fg_ramp_et;
+
+/* Colors of both pixels of each byte of fg for the current effect, the left
+ * one in the low half, and the ramp of their levels. */
+static uint32_t fg_pair[256] = {};
+static fg_ramp_et fg_ramp_kind = FG_RAMP_HALVING;
+
+/* How fg is laid over bg when composing, see `blend_word`. */
+typedef enum
+{
+    BLEND_OR,      /* Colors ORed, as the demo always did. */
+    BLEND_ADD,     /* Channels added, saturating. */
+    BLEND_REPLACE, /* fg where its level is not 0, bg elsewhere. */
+    BLEND_AVERAGE, /* Half of each where the level of fg is not 0. */
+} blend_et;
+
+/* Blend mode of the current effect. */
+static blend_et blend = BLEND_OR;
+
+/* Screen box, inclusive and empty when `x0 > x1`. */
+typedef struct
+{
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+} box_st;
+
+/* Fading any level of fg 8 times leaves 0, so only what was drawn during the
+ * last 8 fades needs fading. Each entry holds what was drawn between two
+ * fades, `fg_dirty_i` is the one being drawn to. */
+#define FG_FADE_COUNT 8U
+static box_st fg_dirty[FG_FADE_COUNT] = {
+    [0 ... FG_FADE_COUNT - 1] = {VIDEO_W, VIDEO_H, -1, -1},
 };
-static uint8_t const vertex_cube_count =
-    sizeof(vertex_cube) / sizeof(vertex_cube[0]);
-static int16_t vertex_gem[10][3][3];
-static uint8_t const vertex_gem_count =
-    sizeof(vertex_gem) / sizeof(vertex_gem[0]);
+static uint8_t fg_dirty_i = 0;
+
+/* Rows of bg or fg that changed since they were last composed into vid, the
+ * others are left as they are. Whatever changes every color of the screen,
+ * the palette or the blend mode, marks them all. */
+static bool row_dirty[VIDEO_H] = {[0 ... VIDEO_H - 1] = true};
+
+/* Marks the rows from `y0` to `y1` as changed, they may reach past the
+ * screen. */
+static void row_dirty_add(int16_t y0, int16_t y1)
+{
+    y0 = y0 < 0 ? 0 : y0;
+    y1 = y1 > VIDEO_H - 1 ? VIDEO_H - 1 : y1;
+    if (y0 <= y1)
+    {
+        memset(&row_dirty[y0], true, y1 - y0 + 1);
+    }
+}
+
+/* Marks the box from `x0`, `y0` to `x1`, `y1` of fg as drawn to, the box may
+ * reach past the screen. */
+static void fg_dirty_add(int16_t const x0, int16_t const y0, int16_t const x1,
+                         int16_t const y1)
+{
+    row_dirty_add(y0, y1);
+    box_st *const box = &fg_dirty[fg_dirty_i];
+    box->x0 = x0 < box->x0 ? (x0 < 0 ? 0 : x0) : box->x0;
+    box->y0 = y0 < box->y0 ? (y0 < 0 ? 0 : y0) : box->y0;
+    box->x1 = x1 > box->x1 ? (x1 > VIDEO_W - 1 ? VIDEO_W - 1 : x1) : box->x1;
+    box->y1 = y1 > box->y1 ? (y1 > VIDEO_H - 1 ? VIDEO_H - 1 : y1) : box->y1;
+}
 
-static void vertex_gem_create()
+/* Fades every pixel of fg drawn to during the last `FG_FADE_COUNT` fades,
+ * eight pixels per word, then starts a new dirty box. */
+static void fg_fade()
 {
-    static float const angle = 2.0f * M_PI / 5.0f;
-    for (uint8_t point_i = 0; point_i < 5; ++point_i)
+    box_st fade = fg_dirty[0];
+    for (uint8_t box_i = 1; box_i < FG_FADE_COUNT; ++box_i)
     {
-        float const a = (float)point_i * angle;
-        float const b = (float)(point_i + 1 % 5) * angle;
+        box_st const *const box = &fg_dirty[box_i];
+        fade.x0 = box->x0 < fade.x0 ? box->x0 : fade.x0;
+        fade.y0 = box->y0 < fade.y0 ? box->y0 : fade.y0;
+        fade.x1 = box->x1 > fade.x1 ? box->x1 : fade.x1;
+        fade.y1 = box->y1 > fade.y1 ? box->y1 : fade.y1;
+    }
 
-        float a_sin, a_cos;
-        sincosf(a, &a_sin, &a_cos);
+    fg_dirty_i = (fg_dirty_i + 1U) % FG_FADE_COUNT;
+    fg_dirty[fg_dirty_i] = (box_st){VIDEO_W, VIDEO_H, -1, -1};
 
-        float b_sin, b_cos;
-        sincosf(b, &b_sin, &b_cos);
+    if (fade.x0 > fade.x1 || fade.y0 > fade.y1)
+    {
+        return;
+    }
+    row_dirty_add(fade.y0, fade.y1);
+    uint16_t const word_first = fade.x0 / 8U;
+    uint16_t const word_end = fade.x1 / 8U + 1U;
+    for (int16_t _y = fade.y0; _y <= fade.y1; ++_y)
+    {
+        uint32_t *const row = (uint32_t *)fg[_y];
+        for (uint16_t word_i = word_first; word_i < word_end; ++word_i)
+        {
+            uint32_t const word = row[word_i];
+            if (fg_ramp_kind == FG_RAMP_LINEAR)
+            {
+                row[word_i] = (word >> 1) & 0x77777777UL;
+            }
+            else
+            {
+                /* Levels of 2 and up lose 2, the others drop to 0. */
+                uint32_t const above =
+                    ((word >> 1) | (word >> 2) | (word >> 3)) & 0x11111111UL;
+                row[word_i] = (word & (above * 0xFU)) - (above << 1);
+            }
+        }
+    }
+}
 
-        int16_t const x1 = (int16_t)(a_sin * 128.0f);
-        int16_t const x2 = (int16_t)(b_sin * 128.0f);
-        int16_t const y1 = (int16_t)(a_cos * 128.0f);
-        int16_t const y2 = (int16_t)(b_cos * 128.0f);
+/* Writes `level` into the pixel at `x` of `fg_row`, a row of fg. */
+static inline void fg_plot(uint8_t *const fg_row, int16_t const x,
+                           uint8_t const level)
+{
+    uint8_t *const pair = &fg_row[x / 2];
+    *pair = x & 1 ? (*pair & 0x0F) | (level << 4) : (*pair & 0xF0) | level;
+}
 
-        int16_t const vertex_a[3][3] = {{x1, y1, 0}, {x2, y2, 0}, {0, 0, 128}};
-        int16_t const vertex_b[3][3] = {{x1, y1, 0}, {x2, y2, 0}, {0, 0, -128}};
-        memcpy(vertex_gem[point_i], vertex_a, sizeof(vertex_a));
-        memcpy(vertex_gem[point_i + 5], vertex_b, sizeof(vertex_b));
+/* Fills fg on row `_y` from `x0` to `x1` with `level`, in any order, clipped
+ * to the screen. Whole bytes are filled two pixels at a time. */
+static void fg_span(int16_t const _y, int16_t x0, int16_t x1,
+                    uint8_t const level)
+{
+    if (x0 > x1)
+    {
+        int16_t const x = x0;
+        x0 = x1;
+        x1 = x;
+    }
+    x0 = x0 < 0 ? 0 : x0;
+    x1 = x1 > VIDEO_W - 1 ? VIDEO_W - 1 : x1;
+    if (x0 > x1)
+    {
+        return;
+    }
+    if (x0 & 1)
+    {
+        fg_plot(fg[_y], x0++, level);
+    }
+    if (!(x1 & 1))
+    {
+        fg_plot(fg[_y], x1--, level);
+    }
+    if (x0 < x1)
+    {
+        memset(&fg[_y][x0 / 2], level * 0x11U, (x1 - x0 + 1) / 2);
     }
 }
 
+/* Spreads the low 8 bits of `bits` to one per pixel of a word of fg, the
+ * pixels whose bit is set get all 4 bits of their level set. */
+static inline uint32_t fg_bits_spread(uint32_t bits)
+{
+    bits &= 0xFFU;
+    bits = (bits | (bits << 12)) & 0x000F000FUL;
+    bits = (bits | (bits << 6)) & 0x03030303UL;
+    bits = (bits | (bits << 3)) & 0x11111111UL;
+    return bits * 0xFU;
+}
+
+#include "mesh_data.h"
+
 static void palette_create()
 {
     for (uint8_t palette_i = 0; palette_i < 6; ++palette_i)
@@ -177,78 +408,116 @@ static void palette_create()
     }
 }
 
-#define FONT_W 3U
-#define FONT_H 5U
-
-/* 3x5 matrix display font. */
-static uint16_t const font_alpha[] = {
-    0x5BEF, /* A */
-    0x7AEF, /* B */
-    0x724F, /* C */
-    0x3B6B, /* D */
-    0x72CF, /* E */
-    0x12CF, /* F */
-    0x7B4F, /* G */
-    0x5BED, /* H */
-    0x7497, /* I */
-    0x7B26, /* J */
-    0x5AED, /* K */
-    0x7249, /* L */
-    0x5B7D, /* M */
-    0x5B6F, /* N */
-    0x7B6F, /* O */
-    0x13EF, /* P */
-    0x4F6F, /* Q */
-    0x5AEF, /* R */
-    0x79CF, /* S */
-    0x2497, /* T */
-    0x7B6D, /* U */
-    0x176D, /* V */
-    0x5F6D, /* W */
-    0x5AAD, /* X */
-    0x24AD, /* Y */
-    0x72A7, /* Z */
-};
-static uint16_t const font_numeric[] = {
-    0x7B6F, /* 0 */
-    0x4926, /* 1 */
-    0x73E7, /* 2 */
-    0x79A7, /* 3 */
-    0x49ED, /* 4 */
-    0x79CF, /* 5 */
-    0x7BCF, /* 6 */
-    0x4927, /* 7 */
-    0x7BEF, /* 8 */
-    0x79EF, /* 9 */
-};
+/* Builds `table`, the current palette rotated by `offset`. */
+static void palette_rotate_table(uint16_t *const table, uint8_t const offset)
+{
+    for (uint16_t color_i = 0; color_i < 255; ++color_i)
+    {
+        uint16_t const color_rot = color_i + offset;
+        table[color_i] = palette_list[palette][color_rot >= 255
+                                                   ? color_rot - 255
+                                                   : color_rot];
+    }
+    /* Colors wrap at 255 so this value has no palette entry, the fire keeps
+     * it as is at any rotation. It always showed the color that follows the
+     * palette in `palette_list`, the first one of the next palette. */
+    table[255] = palette + 1 < 6 ? palette_list[palette + 1][0] : 0;
+}
 
-static void text_draw(uint16_t const _y, uint16_t const x, uint8_t const scale,
-                      char const *const text, uint16_t const len,
-                      uint16_t const color)
+static void palette_rotate()
 {
-    char ch;
-    uint16_t offset_x = 0U;
-    uint16_t offset_y = 0U;
-    for (uint16_t text_idx = 0; text_idx < len; ++text_idx)
+    palette_rotate_table(palette_bg, palette_offset);
+    if (palette_offset != palette_offset_prev)
     {
-        ch = text[text_idx];
+        palette_rotate_table(palette_bg_prev, palette_offset_prev);
+    }
+}
 
-        uint32_t font_glyph;
-        if (ch >= '0' && ch <= '9')
+/* Builds the colors of the levels of fg for `_effect`, from its palette. */
+static void fg_ramp_create(effect_et const _effect)
+{
+    /* Color of the top level of each effect and how the levels below fall
+     * off, the shadebob adds up so its levels are linear. */
+    static uint8_t const effect_fg_color[EFFECT_END + 1] = {
+        0, 250, 0, 254, 210, 60, 210, 210, 128};
+    static fg_ramp_et const effect_fg_ramp[EFFECT_END + 1] = {
+        FG_RAMP_HALVING, FG_RAMP_HALVING, FG_RAMP_HALVING,
+        FG_RAMP_HALVING, FG_RAMP_HALVING, FG_RAMP_LINEAR,
+        FG_RAMP_HALVING, FG_RAMP_HALVING, FG_RAMP_HALVING};
+
+    uint16_t const color = effect_fg_color[_effect];
+    uint16_t ramp[FG_LEVEL_MAX + 1U];
+    fg_ramp_kind = effect_fg_ramp[_effect];
+    for (uint8_t level = 0; level <= FG_LEVEL_MAX; ++level)
+    {
+        uint16_t color_i;
+        if (fg_ramp_kind == FG_RAMP_LINEAR)
+        {
+            color_i = color * level / FG_LEVEL_MAX;
+        }
+        else if (level == 0)
         {
-            ch -= '0';
-            font_glyph = font_numeric[(uint8_t)ch];
+            color_i = 0;
         }
-        else if (ch >= 'A' && ch <= 'Z')
+        else if ((FG_LEVEL_MAX - level) % 2 == 0)
         {
-            ch -= 'A';
-            font_glyph = font_alpha[(uint8_t)ch];
+            color_i = color >> ((FG_LEVEL_MAX - level) / 2);
         }
-        else if (ch == ' ')
+        else
         {
-            font_glyph = 0x0000;
+            /* Half way between two halvings, 181 / 256 is 1 / sqrt(2). */
+            color_i = ((color * 181U) >> 8) >> ((FG_LEVEL_MAX - 1 - level) / 2);
         }
-        else if (ch == '\r')
+        ramp[level] = palette_list[palette][color_i];
+    }
+    for (uint16_t levels = 0; levels < 256; ++levels)
+    {
+        fg_pair[levels] = ramp[levels & 0xFU] | (uint32_t)ramp[levels >> 4]
+                                                    << 16;
+    }
+}
+
+#include "font_atlas.h"
+
+/* Writes `level_word`, a level repeated in all 8 nibbles, into fg row `_y`
+ * wherever `bits` is set, bit 0 being the pixel at `x`. Pixels are written a
+ * word at a time, `bits` may be 32 wide when `x` is a multiple of 8 and 24
+ * wide otherwise. Pixels past the screen are dropped. */
+static void fg_mask_blit(int16_t const _y, int16_t const x, uint32_t bits,
+                         uint32_t const level_word)
+{
+    if (_y < 0 || _y >= VIDEO_H || x < 0 || x >= VIDEO_W)
+    {
+        return;
+    }
+    if (VIDEO_W - x < 32)
+    {
+        bits &= (1UL << (VIDEO_W - x)) - 1U;
+    }
+    bits <<= x % 8U;
+    uint32_t *word = (uint32_t *)fg[_y] + x / 8U;
+    for (; bits; bits >>= 8, ++word)
+    {
+        uint32_t const mask = fg_bits_spread(bits);
+        *word = (*word & ~mask) | (level_word & mask);
+    }
+}
+
+#ifdef BENCH
+/* Draws `len` characters of `text` into fg at `level` with the top left at
+ * `x`, `_y`, `scale` being 1 to `FONT_SCALE_MAX`. "\r\n" starts a new
+ * line. The demo draws text from the cache, the bench compares with this. */
+static void text_draw(uint16_t const _y, uint16_t const x, uint8_t const scale,
+                      char const *const text, uint16_t const len,
+                      uint8_t const level)
+{
+    uint32_t const level_word = level * 0x11111111UL;
+    uint16_t offset_x = 0U;
+    uint16_t offset_y = 0U;
+    for (uint16_t text_idx = 0; text_idx < len; ++text_idx)
+    {
+        char const ch = text[text_idx];
+        if (ch == '\r')
         {
             offset_x = 0U;
             text_idx += 1U;
@@ -260,68 +529,306 @@ static void text_draw(uint16_t const _y, uint16_t const x, uint8_t const scale,
             text_idx += 1U;
             continue;
         }
-        else if (ch == '-')
+
+        uint8_t const *const glyph =
+            font_atlas[scale - 1U][font_glyph_index(ch)];
+        fg_dirty_add(x + offset_x, _y + offset_y,
+                     x + offset_x + FONT_W * scale - 1U,
+                     _y + offset_y + FONT_H * scale - 1U);
+        for (uint8_t row = 0; row < FONT_H * scale; ++row)
         {
-            font_glyph = 0x01C0;
+            fg_mask_blit(_y + offset_y + row, x + offset_x, glyph[row],
+                         level_word);
         }
-        else if (ch == '+')
+
+        offset_x += (FONT_W + 2U) * scale;
+    }
+}
+#endif
+
+/* Words of a row of a cached text, one bit per pixel of the screen. */
+#define TEXT_ROW_WORDS ((VIDEO_W + 31U) / 32U)
+
+/* A line of text rasterised once by `text_cache`, for text that stays the
+ * same from frame to frame. `text_cached_draw` then only copies its set
+ * bits into fg. */
+typedef struct
+{
+    int16_t y;
+    uint8_t row_count;
+    uint32_t level_word;
+    box_st box;
+    uint32_t bits[FONT_H * FONT_SCALE_MAX][TEXT_ROW_WORDS];
+} text_st;
+
+/* Rasterises like `text_draw` into `cached`, on a single line. */
+static void text_cache(text_st *const cached, uint16_t const _y,
+                       uint16_t const x, uint8_t const scale,
+                       char const *const text, uint16_t const len,
+                       uint8_t const level)
+{
+    memset(cached->bits, 0, sizeof(cached->bits));
+    cached->y = _y;
+    cached->row_count = FONT_H * scale;
+    cached->level_word = level * 0x11111111UL;
+    cached->box = (box_st){x, _y, x + len * (FONT_W + 2U) * scale - 1,
+                           _y + FONT_H * scale - 1};
+
+    for (uint16_t text_idx = 0; text_idx < len; ++text_idx)
+    {
+        uint16_t const glyph_x = x + text_idx * (FONT_W + 2U) * scale;
+        if (glyph_x >= VIDEO_W)
         {
-            font_glyph = 0x05D0;
+            break;
         }
-        else if (ch == ':')
+        uint8_t const *const glyph =
+            font_atlas[scale - 1U][font_glyph_index(text[text_idx])];
+        uint16_t const word_i = glyph_x / 32U;
+        uint16_t const shift = glyph_x % 32U;
+        for (uint8_t row = 0; row < cached->row_count; ++row)
         {
-            font_glyph = 0x0410;
+            cached->bits[row][word_i] |= (uint32_t)glyph[row] << shift;
+            if (shift > 24U && word_i + 1U < TEXT_ROW_WORDS)
+            {
+                cached->bits[row][word_i + 1U] |= glyph[row] >> (32U - shift);
+            }
         }
-        else if (ch == '=')
+    }
+}
+
+/* Writes `level_word` into fg wherever `cached` has a pixel. */
+static void text_cached_blit(text_st const *const cached,
+                             uint32_t const level_word)
+{
+    for (uint8_t row = 0; row < cached->row_count; ++row)
+    {
+        for (uint8_t word_i = 0; word_i < TEXT_ROW_WORDS; ++word_i)
         {
-            font_glyph = 0x0E38;
+            if (cached->bits[row][word_i])
+            {
+                fg_mask_blit(cached->y + row, word_i * 32U,
+                             cached->bits[row][word_i], level_word);
+            }
         }
-        else if (ch == '.')
+    }
+}
+
+static void text_cached_draw(text_st const *const cached)
+{
+    fg_dirty_add(cached->box.x0, cached->box.y0, cached->box.x1,
+                 cached->box.y1);
+    text_cached_blit(cached, cached->level_word);
+}
+
+/* Clears the pixels of `cached` in fg back to 0. */
+static void text_cached_erase(text_st const *const cached)
+{
+    row_dirty_add(cached->box.y0, cached->box.y1);
+    text_cached_blit(cached, 0);
+}
+
+/* Retained text layer over fg. A caption is rasterised once when it is
+ * added, drawn into fg on the first frame of its lifetime and erased after
+ * the last one. In between fg keeps it, so a caption costs nothing per frame
+ * until it changes or fg is cleared. */
+typedef struct
+{
+    text_st text;
+    uint32_t frame_first;
+    uint32_t frame_last;
+    bool shown;
+} overlay_st;
+
+#define OVERLAY_MAX 16U
+static overlay_st overlay[OVERLAY_MAX];
+static uint8_t overlay_count = 0;
+
+/* Adds a caption shown from frame `frame_first` to `frame_last`, the other
+ * arguments are those of `text_draw` on a single line. */
+static void overlay_add(uint32_t const frame_first, uint32_t const frame_last,
+                        uint16_t const _y, uint16_t const x,
+                        uint8_t const scale, char const *const text,
+                        uint16_t const len, uint8_t const level)
+{
+    if (overlay_count == OVERLAY_MAX)
+    {
+        return;
+    }
+    overlay_st *const caption = &overlay[overlay_count++];
+    text_cache(&caption->text, _y, x, scale, text, len, level);
+    caption->frame_first = frame_first;
+    caption->frame_last = frame_last;
+    caption->shown = false;
+}
+
+/* fg was cleared, captions still alive are drawn again. */
+static void overlay_invalidate()
+{
+    for (uint8_t caption_i = 0; caption_i < overlay_count; ++caption_i)
+    {
+        overlay[caption_i].shown = false;
+    }
+}
+
+/* Draws the captions that start and erases the ones that ended. */
+static void overlay_update(uint32_t const _frame)
+{
+    for (uint8_t caption_i = 0; caption_i < overlay_count; ++caption_i)
+    {
+        overlay_st *const caption = &overlay[caption_i];
+        bool const alive =
+            _frame >= caption->frame_first && _frame <= caption->frame_last;
+        if (alive && !caption->shown)
         {
-            font_glyph = 0x2000;
+            text_cached_draw(&caption->text);
         }
-        else if (ch == '!')
+        else if (!alive && caption->shown)
         {
-            font_glyph = 0x2092;
+            text_cached_erase(&caption->text);
         }
-        else
+        caption->shown = alive;
+    }
+}
+
+/* Captions of the demo. The title comes in letter by letter during WATER and
+ * the credits stay on from the start of END. */
+static void overlay_create()
+{
+    uint32_t const water_first = effect_frame_first(EFFECT_WATER);
+    uint32_t const water_last = effect_frame_first(EFFECT_ACID) - 1;
+    static char const title[] = "EGO SUM PICO";
+    for (uint8_t letter_i = 0; letter_i < 7; ++letter_i)
+    {
+        overlay_add(water_first + 110 + letter_i * 4U, water_last, 50,
+                    25 + letter_i * 9, 2, &title[letter_i], 1, FG_LEVEL_MAX);
+    }
+    overlay_add(water_first + 150, water_last, 50, 97, 2, &title[8], 4,
+                FG_LEVEL_MAX);
+
+    static char const *const credits[5] = {
+        "DECRUNCH  2023", "     WILD     ", "   RPI PICO   ",
+        " CODE: 1935711", "MUSIC: EIGHTBM",
+    };
+    static uint16_t const credits_y[5] = {36, 44, 52, 64, 72};
+    for (uint8_t line_i = 0; line_i < 5; ++line_i)
+    {
+        overlay_add(effect_frame_first(EFFECT_END), UINT32_MAX,
+                    credits_y[line_i], 46, 1, credits[line_i], 14,
+                    FG_LEVEL_MAX);
+    }
+}
+
+#include "sprite_data.h"
+
+/* Adds the levels of `a` and `b` nibble by nibble, clamping at
+ * `FG_LEVEL_MAX`. */
+static inline uint32_t sprite_lane_add_sat(uint32_t const a, uint32_t const b)
+{
+    uint32_t const high = (a ^ b) & 0x88888888UL;
+    uint32_t const sum = (a & 0x77777777UL) + (b & 0x77777777UL);
+    uint32_t const carry = ((a & b) | (high & sum)) & 0x88888888UL;
+    return (sum ^ high) | ((carry >> 3) * 0xFU);
+}
+
+/* Writes or adds `level` to the pixel at `x` of `fg_row`. */
+static inline void sprite_pixel(uint8_t *const fg_row, int16_t const x,
+                                uint8_t level, bool const additive)
+{
+    uint8_t *const pair = &fg_row[x / 2];
+    uint8_t const shift = (x & 1) * 4U;
+    if (additive)
+    {
+        level += (*pair >> shift) & 0xFU;
+        level = level > FG_LEVEL_MAX ? FG_LEVEL_MAX : level;
+    }
+    *pair = (*pair & ~(0xFU << shift)) | (level << shift);
+}
+
+/* Copies or adds `len` pixels of `src` to `fg_row` from `x` on, a pixel at a
+ * time until `x` starts a word then eight pixels at a time. The top 4 bits of
+ * a sprite pixel are its level. */
+static inline void sprite_run(uint8_t *const fg_row, int16_t x,
+                              uint8_t const *src, int16_t len,
+                              bool const additive)
+{
+    for (; len > 0 && (x & 7); --len, ++x, ++src)
+    {
+        sprite_pixel(fg_row, x, *src >> 4, additive);
+    }
+    uint32_t *word = (uint32_t *)fg_row + x / 8U;
+    for (; len >= 8; len -= 8, x += 8, src += 8, ++word)
+    {
+        uint32_t levels = 0;
+        for (uint8_t pixel_i = 0; pixel_i < 8; ++pixel_i)
         {
-            font_glyph = 0x7B6F;
+            levels |= (uint32_t)(src[pixel_i] >> 4) << (pixel_i * 4U);
         }
+        *word = additive ? sprite_lane_add_sat(*word, levels) : levels;
+    }
+    for (; len > 0; --len, ++x, ++src)
+    {
+        sprite_pixel(fg_row, x, *src >> 4, additive);
+    }
+}
 
-        for (uint8_t i = 0U; i < 15U; ++i)
-        {
-            uint8_t const seg = font_glyph & 0x00000001;
-            uint8_t const draw = seg ? 255U : 0U;
-            font_glyph >>= 1;
+/* Draws `sprite` into fg with its top left at `x`, `_y`, clipped to the
+ * screen. Transparent runs are skipped, opaque ones are copied or, when
+ * `additive`, added with saturation. */
+static inline void sprite_blit(sprite_st const *const sprite, int16_t const x,
+                               int16_t const _y, bool const additive)
+{
+    int16_t const row_first = _y < 0 ? -_y : 0;
+    int16_t const row_end =
+        _y + sprite->h > VIDEO_H ? VIDEO_H - _y : sprite->h;
+    if (row_first >= row_end || x >= VIDEO_W || x + sprite->w <= 0)
+    {
+        return;
+    }
+    fg_dirty_add(x, _y + row_first, x + sprite->w - 1, _y + row_end - 1);
 
-            for (uint8_t scale_y = 0U; scale_y < scale; ++scale_y)
+    for (int16_t row = row_first; row < row_end; ++row)
+    {
+        uint8_t *const fg_row = fg[_y + row];
+        uint8_t const *run = &sprite->data[sprite->row[row]];
+        int16_t run_x = x;
+        for (uint8_t run_count = *run++; run_count > 0; --run_count)
+        {
+            run_x += run[0];
+            uint8_t const len = run[1];
+            uint8_t const *pixel = &run[2];
+            run += 2U + len;
+
+            int16_t run_first = run_x;
+            int16_t const run_end =
+                run_x + len > VIDEO_W ? VIDEO_W : run_x + len;
+            run_x += len;
+            if (run_first < 0)
             {
-                for (uint8_t scale_x = 0U; scale_x < scale; ++scale_x)
-                {
-                    uint16_t const x_common = x + offset_x + scale_x;
-                    uint16_t const y_common = _y + offset_y + scale_y;
-                    if (draw)
-                    {
-                        fg[y_common + ((i / 3U) * scale)]
-                          [x_common + ((i % 3U) * scale)] = color;
-                    }
-                    else
-                    {
-                        if (draw)
-                        {
-                            fg[y_common + ((i / 3U) * scale)]
-                              [x_common + ((i % 3U) * scale)] = 0;
-                        }
-                    }
-                }
+                pixel -= run_first;
+                run_first = 0;
+            }
+            if (run_first < run_end)
+            {
+                sprite_run(fg_row, run_first, pixel, run_end - run_first,
+                           additive);
             }
         }
-
-        offset_x += (FONT_W + 2U) * scale;
     }
 }
 
+static inline void sprite_draw(sprite_st const *const sprite, int16_t const x,
+                               int16_t const _y)
+{
+    sprite_blit(sprite, x, _y, false);
+}
+
+/* For shadebobs, overlapping draws add up towards the brightest color. */
+static inline void sprite_add(sprite_st const *const sprite, int16_t const x,
+                              int16_t const _y)
+{
+    sprite_blit(sprite, x, _y, true);
+}
+
 static uint16_t yx_to_idx(int16_t const _y, int16_t const _x)
 {
     static uint16_t const idx_last = (VIDEO_H * VIDEO_W) - 1;
@@ -340,93 +847,444 @@ static uint16_t yx_to_idx(int16_t const _y, int16_t const _x)
     }
 }
 
-static void fractal(uint32_t const frame_rel, uint16_t const _y,
-                    uint16_t const _x)
+#ifdef BENCH
+/* Samples computed by the fractal kernel. */
+static uint32_t fractal_sample_count = 0;
+#endif
+
+#if FRACTAL_RENDER != FRACTAL_RENDER_STREAM || defined(BENCH)
+/* Iterations of the sample at grid coordinates `_y`, `_x`, up to
+ * `iteration_max`. */
+static uint8_t fractal_iterations(uint32_t const frame_rel, uint16_t const _y,
+                                  uint16_t const _x,
+                                  uint8_t const iteration_max)
+{
+    float const imaginary_c = fractal_imaginary_c(frame_rel);
+#ifdef BENCH
+    ++fractal_sample_count;
+#endif
+#if FRACTAL_FIXED_POINT
+    return fractal_iterate_fixed(fractal_to_fixed(imaginary_c), _y, _x,
+                                 iteration_max);
+#else
+    return fractal_iterate(imaginary_c, _y, _x, iteration_max);
+#endif
+}
+
+/* Color of the sample at grid coordinates `_y`, `_x`. */
+static uint8_t fractal_color(uint32_t const frame_rel, uint16_t const _y,
+                             uint16_t const _x)
+{
+    return (FRACTAL_ITERATION_MAX -
+            fractal_iterations(frame_rel, _y, _x, FRACTAL_ITERATION_MAX)) *
+           2;
+}
+#endif
+
+/* The stream is rendered at build time, the other renders sample here. */
+#if FRACTAL_RENDER != FRACTAL_RENDER_STREAM
+/* Writes a sample color to the 2x2 block of `bg` it covers. */
+static void fractal_block_set(uint16_t const _y, uint16_t const _x,
+                              uint8_t const color)
+{
+    row_dirty_add(_y * 2, _y * 2 + 1);
+    bg[_y * 2][_x * 2] = color;
+    bg[_y * 2][_x * 2 + 1] = color;
+    bg[_y * 2 + 1][_x * 2] = color;
+    bg[_y * 2 + 1][_x * 2 + 1] = color;
+}
+
+/* Computes the sample at grid coordinates `_y`, `_x` into `bg`. */
+static void fractal_sample(uint32_t const frame_rel, uint16_t const _y,
+                           uint16_t const _x)
+{
+    fractal_block_set(_y, _x, fractal_color(frame_rel, _y, _x));
+}
+#endif
+
+#if FRACTAL_RENDER == FRACTAL_RENDER_SUBDIVIDE ||                             \
+    FRACTAL_RENDER == FRACTAL_RENDER_BUDGET
+/* Grid rows of the bands a frame is rendered in. Each band is rendered while
+ * the frame is drawn, so no scanline takes the work of a whole frame. */
+#define FRACTAL_BAND_H 10U
+#define FRACTAL_BAND_COUNT ((FRACTAL_H + FRACTAL_BAND_H - 1) / FRACTAL_BAND_H)
+#endif
+
+#if FRACTAL_RENDER == FRACTAL_RENDER_SUBDIVIDE
+/* Color of a sample that was already computed. */
+static inline uint8_t fractal_sample_color(uint16_t const _y, uint16_t const _x)
 {
-    static float const real_c = -0.7f;
-    static uint8_t const iteration_max = 32;
-    // static float const zoom = 1.2f;
+    return bg[_y * 2][_x * 2];
+}
 
-    float const imaginary_c = 0.27f - (0.004f * frame_rel);
+/* Mariani-Silver subdivision of the grid rectangle between the corners `y0`,
+ * `x0` and `y1`, `x1` (inclusive), whose border is already computed. When the
+ * border has a single color the inside is filled with it, otherwise the
+ * rectangle is split along its longer side and both halves are handled the
+ * same way. */
+static void fractal_subdivide(uint32_t const frame_rel, uint16_t const y0,
+                              uint16_t const x0, uint16_t const y1,
+                              uint16_t const x1)
+{
+    if (y1 - y0 < 2 || x1 - x0 < 2)
+    {
+        return; /* No inside left. */
+    }
 
-    /* Calculate the initial real and imaginary part of z, based on the pixel
-     * location and zoom and position values. */
-    float real_new =
-        1.5f * ((float)_x - (float)VIDEO_W_2) / (96.0 /* zoom * VIDEO_W_2 */);
-    float imaginary_new =
-        ((float)_y - (float)VIDEO_H_2) / (72.0 /* zoom * VIDEO_H_2 */);
+    uint8_t const color = fractal_sample_color(y0, x0);
+    bool uniform = true;
+    for (uint16_t _x = x0; _x <= x1 && uniform; ++_x)
+    {
+        uniform = fractal_sample_color(y0, _x) == color &&
+                  fractal_sample_color(y1, _x) == color;
+    }
+    for (uint16_t _y = y0 + 1; _y < y1 && uniform; ++_y)
+    {
+        uniform = fractal_sample_color(_y, x0) == color &&
+                  fractal_sample_color(_y, x1) == color;
+    }
 
-    uint8_t iteration;
-    for (iteration = 0; iteration < iteration_max; iteration++)
+    if (uniform)
     {
-        // Remember value of previous iteration.
-        float const real_old = real_new;
-        float const imaginary_old = imaginary_new;
-        // The actual iteration, the real and imaginary part are calculated.
-        real_new = real_old * real_old - imaginary_old * imaginary_old + real_c;
-        imaginary_new = 2.0f * real_old * imaginary_old + imaginary_c;
-        // If the point is outside the circle with radius 2: stop.
-        if ((real_new * real_new + imaginary_new * imaginary_new) > 1.5f)
+        for (uint16_t _y = (y0 + 1) * 2; _y < y1 * 2; ++_y)
         {
-            break;
+            memset(&bg[_y][(x0 + 1) * 2], color, (x1 - x0 - 1) * 2);
+        }
+        row_dirty_add((y0 + 1) * 2, y1 * 2 - 1);
+    }
+    else if (x1 - x0 >= y1 - y0)
+    {
+        uint16_t const x_mid = (x0 + x1) / 2;
+        for (uint16_t _y = y0 + 1; _y < y1; ++_y)
+        {
+            fractal_sample(frame_rel, _y, x_mid);
         }
+        fractal_subdivide(frame_rel, y0, x0, y1, x_mid);
+        fractal_subdivide(frame_rel, y0, x_mid, y1, x1);
     }
+    else
+    {
+        uint16_t const y_mid = (y0 + y1) / 2;
+        for (uint16_t _x = x0 + 1; _x < x1; ++_x)
+        {
+            fractal_sample(frame_rel, y_mid, _x);
+        }
+        fractal_subdivide(frame_rel, y0, x0, y_mid, x1);
+        fractal_subdivide(frame_rel, y_mid, x0, y1, x1);
+    }
+}
 
-    uint8_t const color = iteration_max - iteration;
-    bg[_y][_x] = color * 2;
+/* Renders by subdivision the band of grid rows from `y0` to the next band. The
+ * top border row of a band is the bottom one of the band above. */
+static void fractal_band(uint32_t const frame_rel, uint16_t const y0)
+{
+    uint16_t const y1 = y0 + FRACTAL_BAND_H < FRACTAL_H - 1
+                            ? y0 + FRACTAL_BAND_H
+                            : FRACTAL_H - 1;
+    for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+    {
+        if (y0 == 0)
+        {
+            fractal_sample(frame_rel, 0, _x);
+        }
+        fractal_sample(frame_rel, y1, _x);
+    }
+    for (uint16_t _y = y0 + 1; _y < y1; ++_y)
+    {
+        fractal_sample(frame_rel, _y, 0);
+        fractal_sample(frame_rel, _y, FRACTAL_W - 1);
+    }
+    fractal_subdivide(frame_rel, y0, 0, y1, FRACTAL_W - 1);
 }
+#endif
+
+#if FRACTAL_RENDER == FRACTAL_RENDER_STREAM
+/* Read position in `fractal_stream` and the frames decoded from it. */
+static uint8_t const *fractal_stream_pos = fractal_stream;
+static uint32_t fractal_stream_frames = 0;
 
-static void energy_transfer(uint16_t const idx_src, uint16_t const idx_dst)
+/* Decodes the next sample row of `fractal_stream` into the 2 rows of `bg` it
+ * covers, see tools/fractal_gen.c for the format. */
+static void fractal_stream_row(uint16_t const _y)
 {
-    uint8_t const transfer_amount = bg_idx[idx_src] / 2;
-    uint16_t const transfer_max = (uint16_t)256 - (uint16_t)bg_idx[idx_dst];
-    if (transfer_max > transfer_amount)
+    uint8_t *const row = bg[_y * 2];
+    uint16_t _x = 0;
+    bool changed = false;
+    while (_x < VIDEO_W)
     {
-        bg_idx[idx_src] -= transfer_amount;
-        bg_idx[idx_dst] = bg_idx[idx_dst] + transfer_amount > 255
-                              ? 0
-                              : bg_idx[idx_dst] + transfer_amount;
+        uint8_t const token = *fractal_stream_pos++;
+        if (token & 0x80)
+        {
+            _x += ((token & 0x7F) + 1) * 2;
+            continue;
+        }
+        changed = true;
+
+        uint16_t run = 2;
+        uint8_t level = token;
+        if (token & 0x40)
+        {
+            run = ((token & 0x3F) + 1) * 2;
+            level = *fractal_stream_pos++;
+        }
+        memset(&row[_x], level * 2, run);
+        _x += run;
     }
-    else
+    /* Rows held from the previous frame need no composing. */
+    if (changed)
     {
-        bg_idx[idx_src] -= transfer_max > 255 ? 255 : transfer_max;
-        bg_idx[idx_dst] = bg_idx[idx_dst] + transfer_max > 255
-                              ? 0
-                              : bg_idx[idx_dst] + transfer_max;
+        memcpy(bg[_y * 2 + 1], row, VIDEO_W);
+        row_dirty_add(_y * 2, _y * 2 + 1);
     }
 }
 
-static void fire(effect_et const _effect, uint16_t const _y, uint16_t const _x)
+/* Decodes the frame of the fractal for `frame_rel` from the stream, the last
+ * frame is held if the effect runs longer. */
+static void fractal_stream_decode(uint32_t const frame_rel)
 {
-    uint32_t const idx_self = yx_to_idx(_y, _x);
+    if (frame_rel == FRACTAL_FRAME_REL_FIRST)
+    {
+        fractal_stream_pos = fractal_stream;
+        fractal_stream_frames = 0;
+    }
+    if (fractal_stream_frames == FRACTAL_STREAM_FRAMES)
+    {
+        return;
+    }
 
-    switch (_effect)
+    for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
     {
-    case EFFECT_FIRE_A:
-    case EFFECT_FIRE_B: {
-        if (_y == 0 && _x == 0)
+        fractal_stream_row(_y);
+    }
+    ++fractal_stream_frames;
+}
+#endif
+
+#if FRACTAL_RENDER == FRACTAL_RENDER_BUDGET
+/* Samples that reached the coarse iteration count, one bit each. */
+static uint32_t fractal_capped[(FRACTAL_W * FRACTAL_H + 31) / 32] = {};
+/* Per band, the next sample of the coarse pass and the next one to refine,
+ * counted from the first sample of the band. Both are carried over to the
+ * next frame when time runs out. */
+static uint16_t fractal_coarse_idx[FRACTAL_BAND_COUNT] = {};
+static uint16_t fractal_refine_idx[FRACTAL_BAND_COUNT] = {};
+
+/* Renders the band of grid rows from `y0` within its share of
+ * `FRACTAL_BUDGET_US`. A coarse pass settles every sample that escapes within
+ * `FRACTAL_COARSE_ITERATIONS`, the others keep their color from earlier frames
+ * as long as it is not brighter than the coarse one. Then those samples are
+ * recomputed with the full iteration count, in turns across frames, until the
+ * time is up. When it is up before the coarse pass is done, the next frame
+ * resumes the pass and the samples it has not reached keep their color. */
+static void fractal_budget_band(uint32_t const frame_rel, uint16_t const y0)
+{
+    uint32_t const start = time_us_32();
+    uint16_t const band = y0 / FRACTAL_BAND_H;
+    uint16_t const idx_first = y0 * FRACTAL_W;
+    uint16_t const sample_count =
+        (y0 + FRACTAL_BAND_H < FRACTAL_H ? FRACTAL_BAND_H : FRACTAL_H - y0) *
+        FRACTAL_W;
+    uint8_t const color_capped =
+        (FRACTAL_ITERATION_MAX - FRACTAL_COARSE_ITERATIONS) * 2;
+
+    for (; fractal_coarse_idx[band] < sample_count; ++fractal_coarse_idx[band])
+    {
+        if (time_us_32() - start >= FRACTAL_BUDGET_US / FRACTAL_BAND_COUNT)
         {
-            for (uint16_t __x = 0; __x < VIDEO_W; ++__x)
+            return;
+        }
+        uint16_t const idx = idx_first + fractal_coarse_idx[band];
+        uint16_t const _y = idx / FRACTAL_W;
+        uint16_t const _x = idx % FRACTAL_W;
+        uint8_t const iterations =
+            fractal_iterations(frame_rel, _y, _x, FRACTAL_COARSE_ITERATIONS);
+        uint32_t const capped_bit = 1UL << (idx % 32);
+        if (iterations < FRACTAL_COARSE_ITERATIONS)
+        {
+            fractal_capped[idx / 32] &= ~capped_bit;
+            fractal_block_set(_y, _x,
+                              (FRACTAL_ITERATION_MAX - iterations) * 2);
+        }
+        else
+        {
+            fractal_capped[idx / 32] |= capped_bit;
+            if (bg[_y * 2][_x * 2] > color_capped)
             {
-                bg[VIDEO_H - 1][__x] = 255;
+                fractal_block_set(_y, _x, color_capped);
             }
         }
-        break;
     }
-    case EFFECT_ACID:
-    case EFFECT_WATER: {
-        if (frame % 2 == 0)
+    fractal_coarse_idx[band] = 0;
+
+    for (uint16_t visited = 0;
+         visited < sample_count &&
+         time_us_32() - start < FRACTAL_BUDGET_US / FRACTAL_BAND_COUNT;
+         ++visited)
+    {
+        uint16_t const idx = idx_first + fractal_refine_idx[band];
+        fractal_refine_idx[band] =
+            fractal_refine_idx[band] + 1 < sample_count
+                ? fractal_refine_idx[band] + 1
+                : 0;
+        if (fractal_capped[idx / 32] & (1UL << (idx % 32)))
         {
-            bg[_y][_x] = (bg[_y][_x] + 2) % 255;
+            fractal_sample(frame_rel, idx / FRACTAL_W, idx % FRACTAL_W);
         }
-        break;
     }
+}
+#endif
+
+#if FRACTAL_RENDER == FRACTAL_RENDER_PROGRESSIVE
+/* Whether the progressive render recomputes the sample at `_y`, `_x` in this
+ * frame, the others keep their color from the previous frames. Two phases
+ * interlace samples as a checkerboard, four also split it by rows. The first
+ * frame of the effect computes everything. */
+static inline bool fractal_sample_due(uint32_t const frame_rel,
+                                      uint16_t const _y, uint16_t const _x)
+{
+    uint32_t const frame_effect = frame_rel - FRACTAL_FRAME_REL_FIRST;
+    uint8_t const phase = (((_x + _y) & 1) | ((_y & 1) << 1)) % FRACTAL_PHASES;
+    return frame_effect == 0 || phase == frame_effect % FRACTAL_PHASES;
+}
+#endif
+
+/* Draw order position of the cell being updated by the fire automaton. */
+static uint16_t fire_rank = 0;
+
+/* Position of a cell in the order `scanline` draws them. */
+static inline uint16_t draw_rank(uint16_t const idx)
+{
+    return idx >= DRAW_AHEAD * VIDEO_W ? idx - DRAW_AHEAD * VIDEO_W
+                                       : idx + (VIDEO_H - DRAW_AHEAD) * VIDEO_W;
+}
+
+/* Actual value of a cell stored as `raw` relative to the palette rotation
+ * `offset`. Values wrap at 255 so 255 itself is kept as is, it only exists
+ * until the cell is next rotated, where it wraps like 0. */
+static inline uint8_t fire_decode(uint8_t const raw, uint8_t const offset)
+{
+    if (raw == 255)
+    {
+        return 255;
+    }
+    uint16_t const val = raw + offset;
+    return val < 255 ? val : val - 255;
+}
+
+static inline uint8_t fire_encode(uint8_t const val, uint8_t const offset)
+{
+    if (val == 255)
+    {
+        return 255;
+    }
+    uint16_t const raw = val + (255 - offset);
+    return raw < 255 ? raw : raw - 255;
+}
+
+/* The fire automaton works on the actual values, while `bg` stores them
+ * relative to the palette rotation when the effect `drift`s. A cell that was
+ * not drawn yet in this frame is still at the rotation of the previous frame,
+ * so the rules see the same drifting values as when every cell was incremented
+ * in place. The draw order is only looked at when `rotating`, in the frames
+ * where the rotation moves. */
+static inline __attribute__((always_inline)) uint8_t
+fire_offset(uint16_t const idx, bool const drift, bool const rotating)
+{
+    if (!drift)
+    {
+        return 0;
+    }
+    if (!rotating)
+    {
+        return palette_offset;
+    }
+    return draw_rank(idx) <= fire_rank ? palette_offset : palette_offset_prev;
+}
+
+static inline __attribute__((always_inline)) uint8_t
+fire_get(uint16_t const idx, bool const drift, bool const rotating)
+{
+    return fire_decode(bg_idx[idx], fire_offset(idx, drift, rotating));
+}
+
+static inline __attribute__((always_inline)) void
+fire_set(uint16_t const idx, uint8_t const val, bool const drift,
+         bool const rotating)
+{
+    bg_idx[idx] = fire_encode(val, fire_offset(idx, drift, rotating));
+}
+
+static inline __attribute__((always_inline)) void
+energy_transfer(uint16_t const idx_src, uint16_t const idx_dst,
+                bool const drift, bool const rotating)
+{
+    uint8_t const val_src = fire_get(idx_src, drift, rotating);
+    uint8_t const transfer_amount = val_src / 2;
+    uint16_t const transfer_max =
+        (uint16_t)256 - (uint16_t)fire_get(idx_dst, drift, rotating);
+    if (transfer_max > transfer_amount)
+    {
+        fire_set(idx_src, val_src - transfer_amount, drift, rotating);
+        uint8_t const val_dst = fire_get(idx_dst, drift, rotating);
+        fire_set(idx_dst,
+                 val_dst + transfer_amount > 255 ? 0
+                                                 : val_dst + transfer_amount,
+                 drift, rotating);
+    }
+    else
+    {
+        fire_set(idx_src, val_src - (transfer_max > 255 ? 255 : transfer_max),
+                 drift, rotating);
+        uint8_t const val_dst = fire_get(idx_dst, drift, rotating);
+        fire_set(idx_dst,
+                 val_dst + transfer_max > 255 ? 0 : val_dst + transfer_max,
+                 drift, rotating);
+    }
+}
+
+static inline __attribute__((always_inline)) void
+fire_cell(effect_et const _effect, uint16_t const _y, uint16_t const _x,
+          bool const drift, bool const rotating)
+{
+    uint32_t const idx_self = yx_to_idx(_y, _x);
+    if (rotating)
+    {
+        fire_rank = draw_rank(idx_self);
+    }
+    /* Energy moves between rows all over the screen. */
+    if (_y == 0 && _x == 0)
+    {
+        row_dirty_add(0, VIDEO_H - 1);
+    }
+
+    switch (_effect)
+    {
+    case EFFECT_FIRE_A:
+    case EFFECT_FIRE_B: {
+        if (_y == 0 && _x == 0)
+        {
+            for (uint16_t __x = 0; __x < VIDEO_W; ++__x)
+            {
+                bg[VIDEO_H - 1][__x] = 255;
+            }
+        }
+        break;
+    }
+    case EFFECT_ACID:
+    case EFFECT_WATER:
+        /* Colors drift through `palette_offset`. A 255 is kept as is, so
+         * when it is rotated it is rewritten the way a 0 wraps. */
+        if (rotating && bg_idx[idx_self] == 255)
+        {
+            bg_idx[idx_self] = fire_encode(0, palette_offset_prev);
+        }
+        break;
     default:
         __builtin_unreachable();
     }
 
     /* Cache current value to not have to re-read buffer. */
-    uint8_t const val = bg_idx[yx_to_idx(_y, _x)];
+    uint8_t const val = fire_get(idx_self, drift, rotating);
 
     int8_t const moore[] = {-1, -1, -1, 0, 1, 1, 1, 0, -1, -1};
     uint8_t const moore_north = _effect == EFFECT_ACID ? 7 : 1;
@@ -440,7 +1298,7 @@ static void fire(effect_et const _effect, uint16_t const _y, uint16_t const _x)
         int16_t const neighbor_y = _y + moore[neighbor];
 
         uint16_t const neighbor_idx = yx_to_idx(neighbor_y, neighbor_x);
-        uint8_t const neighbor_val = bg_idx[neighbor_idx];
+        uint8_t const neighbor_val = fire_get(neighbor_idx, drift, rotating);
         neighbor_val_tot += neighbor_val;
 
         if (neighbor_val < neighbor_val_min)
@@ -458,15 +1316,16 @@ static void fire(effect_et const _effect, uint16_t const _y, uint16_t const _x)
         uint16_t const neighbor_min_idx =
             yx_to_idx(neighbor_min_y, neighbor_min_x);
 
-        energy_transfer(idx_self, neighbor_min_idx);
+        energy_transfer(idx_self, neighbor_min_idx, drift, rotating);
         /* We don't update the `val` value here intentionally for a better
          * effect, even though it changed. */
     }
 
     // Cool down places that have a cooler neighborhood.
-    if (neighbor_val_tot / 8 < val && bg_idx[idx_self] > 0)
+    uint8_t const val_self = fire_get(idx_self, drift, rotating);
+    if (neighbor_val_tot / 8 < val && val_self > 0)
     {
-        bg_idx[idx_self] -= 1;
+        fire_set(idx_self, val_self - 1, drift, rotating);
     }
 
     // Transfer up due to convection.
@@ -477,7 +1336,7 @@ static void fire(effect_et const _effect, uint16_t const _y, uint16_t const _x)
     {
         uint16_t const neighbor_north_idx =
             yx_to_idx(neighbor_north_y, neighbor_north_x);
-        energy_transfer(idx_self, neighbor_north_idx);
+        energy_transfer(idx_self, neighbor_north_idx, drift, rotating);
     }
     if (val > 128)
     {
@@ -487,9 +1346,1657 @@ static void fire(effect_et const _effect, uint16_t const _y, uint16_t const _x)
         uint16_t const idx_south = yx_to_idx(_y + 1, _x);
         if (_y + 1 < VIDEO_H)
         {
-            energy_transfer(idx_south, neighbor_north_idx);
+            energy_transfer(idx_south, neighbor_north_idx, drift, rotating);
+        }
+    }
+}
+
+/* FIRE_A and FIRE_B keep the values in `bg` as they are, WATER and ACID only
+ * look at the draw order in the frames where the palette rotates. */
+static void fire(effect_et const _effect, uint16_t const _y, uint16_t const _x)
+{
+    if (_effect == EFFECT_FIRE_A || _effect == EFFECT_FIRE_B)
+    {
+        fire_cell(_effect, _y, _x, false, false);
+    }
+    else if (palette_offset == palette_offset_prev)
+    {
+        fire_cell(_effect, _y, _x, true, false);
+    }
+    else
+    {
+        fire_cell(_effect, _y, _x, true, true);
+    }
+}
+
+#if !THREEDEE_FILLED
+/* Outcodes of Cohen-Sutherland clipping, the sides of the screen a point is
+ * beyond. */
+#define CLIP_LEFT 1U
+#define CLIP_RIGHT 2U
+#define CLIP_TOP 4U
+#define CLIP_BOTTOM 8U
+
+static uint8_t clip_code(int16_t const _x, int16_t const _y)
+{
+    uint8_t code = 0;
+    if (_x < 0)
+    {
+        code |= CLIP_LEFT;
+    }
+    else if (_x > VIDEO_W - 1)
+    {
+        code |= CLIP_RIGHT;
+    }
+    if (_y < 0)
+    {
+        code |= CLIP_TOP;
+    }
+    else if (_y > VIDEO_H - 1)
+    {
+        code |= CLIP_BOTTOM;
+    }
+    return code;
+}
+
+/* Clips the line between `x0`, `y0` and `x1`, `y1` to the screen, false if
+ * none of it is on screen. Each clip moves an endpoint along the line towards
+ * the other one, so it never leaves a side it is already inside of. */
+static bool line_clip(int16_t *const x0, int16_t *const y0, int16_t *const x1,
+                      int16_t *const y1)
+{
+    uint8_t code0 = clip_code(*x0, *y0);
+    uint8_t code1 = clip_code(*x1, *y1);
+    for (;;)
+    {
+        if (!(code0 | code1))
+        {
+            return true;
+        }
+        if (code0 & code1)
+        {
+            return false;
+        }
+
+        uint8_t const code = code0 ? code0 : code1;
+        int32_t const dx = *x1 - *x0;
+        int32_t const dy = *y1 - *y0;
+        int32_t _x, _y;
+        if (code & CLIP_TOP)
+        {
+            _y = 0;
+            _x = *x0 + dx * (_y - *y0) / dy;
+        }
+        else if (code & CLIP_BOTTOM)
+        {
+            _y = VIDEO_H - 1;
+            _x = *x0 + dx * (_y - *y0) / dy;
+        }
+        else if (code & CLIP_LEFT)
+        {
+            _x = 0;
+            _y = *y0 + dy * (_x - *x0) / dx;
+        }
+        else
+        {
+            _x = VIDEO_W - 1;
+            _y = *y0 + dy * (_x - *x0) / dx;
+        }
+
+        if (code == code0)
+        {
+            *x0 = _x;
+            *y0 = _y;
+            code0 = clip_code(_x, _y);
+        }
+        else
+        {
+            *x1 = _x;
+            *y1 = _y;
+            code1 = clip_code(_x, _y);
+        }
+    }
+}
+
+/* Draws a line into fg, clipped to the screen. Horizontal lines are spans,
+ * all others are stepped through fg without bounds checks. */
+static void bresenham(uint8_t const level, int16_t x0, int16_t y0, int16_t x1,
+                      int16_t y1)
+{
+    if (!line_clip(&x0, &y0, &x1, &y1))
+    {
+        return;
+    }
+
+    if (y0 == y1)
+    {
+        fg_span(y0, x0, x1, level);
+        return;
+    }
+    if (x0 == x1)
+    {
+        int16_t const y_min = y0 < y1 ? y0 : y1;
+        uint8_t *fg_row = fg[y_min];
+        for (int16_t len = abs(y1 - y0) + 1; len > 0; --len)
+        {
+            fg_plot(fg_row, x0, level);
+            fg_row += VIDEO_W / 2;
+        }
+        return;
+    }
+
+    int16_t const dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int16_t const dy = -abs(y1 - y0), sy = y0 < y1 ? VIDEO_W / 2 : -VIDEO_W / 2;
+    int16_t err = dx + dy, e2; /* error value e_xy */
+    uint8_t *fg_row = fg[y0];
+    uint8_t const *const fg_row_last = fg[y1];
+
+    for (;;)
+    {
+        fg_plot(fg_row, x0, level);
+
+        if (x0 == x1 && fg_row == fg_row_last)
+        {
+            break;
+        }
+        e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x0 += sx;
+        } /* e_xy+e_x > 0 */
+        if (e2 <= dx)
+        {
+            err += dx;
+            fg_row += sy;
+        } /* e_xy+e_y < 0 */
+    }
+}
+#endif
+
+/* o = a * b, for 4x4 matrices. */
+static void matrix_concat(float o[4][4], float const a[4][4],
+                          float const b[4][4])
+{
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        for (uint8_t j = 0; j < 4; ++j)
+        {
+            o[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] +
+                      a[i][2] * b[2][j] + a[i][3] * b[3][j];
+        }
+    }
+}
+
+static float const threedee_near_clip = 1.0f;
+static float const threedee_far_clip = 100.0f;
+static float const threedee_fov_rad = 1.0f;
+static float const threedee_aspect_ratio = (float)VIDEO_H / (float)VIDEO_W;
+static float const threedee_projection[4][4] = {
+    {threedee_aspect_ratio * threedee_fov_rad, 0, 0, 0},
+    {0, threedee_fov_rad, 0, 0},
+    {0, 0, threedee_far_clip / (threedee_far_clip - threedee_near_clip), 1.0f},
+    {0, 0,
+     (-threedee_far_clip * threedee_near_clip) /
+         (threedee_far_clip - threedee_near_clip),
+     0}};
+/* Offset into the screen. */
+static float const threedee_translate[4][4] = {
+    {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 3.0f, 1}};
+
+/* Rotations of the shapes at angle `theta`. */
+static void threedee_rotation(effect_et const _effect, float const theta,
+                              float rot_z[4][4], float rot_x[4][4])
+{
+    memset(rot_z, 0, sizeof(float[4][4]));
+    memset(rot_x, 0, sizeof(float[4][4]));
+
+    float theta_sin, theta_cos;
+    sincosf(theta, &theta_sin, &theta_cos);
+
+    float theta_half_sin, theta_half_cos;
+    sincosf(theta * 0.5f, &theta_half_sin, &theta_half_cos);
+
+    rot_z[0][0] = theta_cos;
+    rot_z[0][1] = theta_sin;
+    rot_z[1][0] = -theta_sin;
+    rot_z[1][1] = theta_cos;
+    rot_z[2][2] = 1;
+    rot_z[3][3] = 1;
+    if (_effect == EFFECT_3D_B || _effect == EFFECT_FIRE_C)
+    {
+        rot_z[0][1] = -theta_half_sin;
+    }
+
+    rot_x[0][0] = 1;
+    rot_x[1][1] = theta_half_cos;
+    rot_x[1][2] = theta_half_sin;
+    rot_x[2][1] = -theta_half_sin;
+    rot_x[2][2] = theta_half_cos;
+    rot_x[3][3] = 1;
+}
+
+/* Screen offset of the shapes at angle `theta`. */
+static void threedee_move(float const theta, float *const move_x,
+                          float *const move_y)
+{
+    float theta_sin, theta_cos;
+    sincosf(theta, &theta_sin, &theta_cos);
+    float theta_1p4_sin, theta_1p4_cos;
+    sincosf(theta * 1.4f, &theta_1p4_sin, &theta_1p4_cos);
+    *move_x = theta_sin * 35.0f;
+    *move_y = theta_1p4_cos * 20.0f;
+}
+
+/* Rotation, translation, projection and scaling into the screen of the current
+ * frame as one Q16 matrix, for row vectors. The columns are the screen x and y
+ * before the perspective divide, then w. */
+static int32_t threedee_matrix[4][3];
+/* Depth column of the rotation in Q14, turns a normal into its depth. */
+static int32_t threedee_normal_z[3];
+
+static void threedee_matrix_create(effect_et const _effect, float const theta)
+{
+    float rot_z[4][4];
+    float rot_x[4][4];
+    threedee_rotation(_effect, theta, rot_z, rot_x);
+    float move_x, move_y;
+    threedee_move(theta, &move_x, &move_y);
+    /* From -1 to 1 into the screen, times w as the divide comes last. */
+    float const screen[4][4] = {{VIDEO_W_2, 0, 0, 0},
+                                {0, VIDEO_H_2, 0, 0},
+                                {0, 0, 1, 0},
+                                {VIDEO_W_2 + move_x, VIDEO_H_2 + move_y, 0, 1}};
+
+    float rotate[4][4];
+    float world[4][4];
+    float project[4][4];
+    float m[4][4];
+    matrix_concat(rotate, rot_z, rot_x);
+    matrix_concat(world, rotate, threedee_translate);
+    matrix_concat(project, world, threedee_projection);
+    matrix_concat(m, project, screen);
+
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        threedee_matrix[i][0] = (int32_t)(m[i][0] * 65536.0f);
+        threedee_matrix[i][1] = (int32_t)(m[i][1] * 65536.0f);
+        threedee_matrix[i][2] = (int32_t)(m[i][3] * 65536.0f);
+    }
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        threedee_normal_z[i] = (int32_t)(rotate[i][2] * 16384.0f);
+    }
+}
+
+/* Screen position of `vertex`, in Q7, with `threedee_matrix`. Every product
+ * fits in 32 bits as the entries stay below 2^24. Positions may be off screen,
+ * lines are clipped. */
+static void threedee_project(int16_t const vertex[3], int16_t o[2])
+{
+    int32_t p[3];
+    for (uint8_t j = 0; j < 3; ++j)
+    {
+        p[j] = ((vertex[0] * threedee_matrix[0][j]) >> 7) +
+               ((vertex[1] * threedee_matrix[1][j]) >> 7) +
+               ((vertex[2] * threedee_matrix[2][j]) >> 7) +
+               threedee_matrix[3][j];
+    }
+    /* w stays above 1 for the shapes drawn. */
+    o[0] = hw_divider_quotient_s32(p[0], p[2]);
+    o[1] = hw_divider_quotient_s32(p[1], p[2]);
+}
+
+#if THREEDEE_FILLED
+/* Fills the triangle between screen positions `a`, `b` and `c` in fg, one span
+ * per row from top to bottom. The edges are stepped in Q16. */
+static void triangle_fill(int16_t const *a, int16_t const *b,
+                          int16_t const *c, uint8_t const level)
+{
+    /* Sorted by y. */
+    int16_t const *swap;
+    if (b[1] < a[1])
+    {
+        swap = a, a = b, b = swap;
+    }
+    if (c[1] < a[1])
+    {
+        swap = a, a = c, c = swap;
+    }
+    if (c[1] < b[1])
+    {
+        swap = b, b = c, c = swap;
+    }
+    if (c[1] < 0 || a[1] > VIDEO_H - 1 || a[1] == c[1])
+    {
+        return;
+    }
+
+    int16_t const y_first = a[1] < 0 ? 0 : a[1];
+    int16_t const y_last = c[1] > VIDEO_H - 1 ? VIDEO_H - 1 : c[1];
+    /* Edge a to c spans every row, a to b and b to c share the rest. */
+    int32_t const long_step = ((c[0] - a[0]) << 16) / (c[1] - a[1]);
+    int32_t long_x = (a[0] << 16) + long_step * (y_first - a[1]) + 0x8000;
+    int16_t const *short_from = y_first < b[1] ? a : b;
+    int16_t const *short_to = y_first < b[1] ? b : c;
+    int32_t short_step =
+        short_to[1] == short_from[1]
+            ? 0
+            : ((short_to[0] - short_from[0]) << 16) /
+                  (short_to[1] - short_from[1]);
+    int32_t short_x = (short_from[0] << 16) +
+                      short_step * (y_first - short_from[1]) + 0x8000;
+
+    for (int16_t _y = y_first; _y <= y_last; ++_y)
+    {
+        if (_y == b[1] && short_to == b)
+        {
+            /* Bottom half. */
+            short_step = c[1] == b[1]
+                             ? 0
+                             : ((c[0] - b[0]) << 16) / (c[1] - b[1]);
+            short_x = (b[0] << 16) + 0x8000;
+            short_to = c;
+        }
+        fg_span(_y, long_x >> 16, short_x >> 16, level);
+        long_x += long_step;
+        short_x += short_step;
+    }
+}
+
+/* Level of a face lit from the viewer, from a quarter of the color of the
+ * effect when seen edge on to all of it when facing the screen. Two levels
+ * halve the color, so this is 4 levels below the top at most. */
+static uint8_t threedee_shade(int16_t const normal[3])
+{
+    int32_t const depth = (normal[0] * threedee_normal_z[0] +
+                           normal[1] * threedee_normal_z[1] +
+                           normal[2] * threedee_normal_z[2]) >>
+                          14;
+    /* Facing the viewer is towards negative depth. */
+    int32_t const light = depth < 0 ? -depth : 0;
+    /* Brightness out of 256, against its half level steps. */
+    uint16_t const bright = 64 + ((192 * light) >> 14);
+    static uint16_t const level_min[4] = {215, 152, 108, 76};
+    uint8_t level = FG_LEVEL_MAX;
+    for (uint8_t step = 0; step < 4 && bright < level_min[step]; ++step)
+    {
+        --level;
+    }
+    return level;
+}
+#endif
+
+/* Screen positions of the vertices of the mesh drawn. */
+static int16_t mesh_screen[MESH_VERTEX_MAX][2];
+
+static void threedee(effect_et const _effect, uint32_t const _frame,
+                     mesh_st const *const mesh, uint16_t const _y,
+                     uint16_t const _x)
+{
+    if (_y == 0 && _x == 0)
+    {
+        fg_fade();
+
+        threedee_matrix_create(_effect, _frame / 8.0f);
+
+        box_st box = {VIDEO_W, VIDEO_H, -1, -1};
+        for (uint8_t vertex_i = 0; vertex_i < mesh->vertex_count; ++vertex_i)
+        {
+            int16_t *const o = mesh_screen[vertex_i];
+            threedee_project(mesh->vertex[vertex_i], o);
+            box.x0 = o[0] < box.x0 ? o[0] : box.x0;
+            box.y0 = o[1] < box.y0 ? o[1] : box.y0;
+            box.x1 = o[0] > box.x1 ? o[0] : box.x1;
+            box.y1 = o[1] > box.y1 ? o[1] : box.y1;
+        }
+        fg_dirty_add(box.x0, box.y0, box.x1, box.y1);
+#if THREEDEE_FILLED
+        for (uint8_t face_i = 0; face_i < mesh->face_count; ++face_i)
+        {
+            int16_t const *const a = mesh_screen[mesh->face[face_i][0]];
+            int16_t const *const b = mesh_screen[mesh->face[face_i][1]];
+            int16_t const *const c = mesh_screen[mesh->face[face_i][2]];
+            /* Back faces wind the other way round once projected. */
+            int32_t const area = (b[0] - a[0]) * (c[1] - a[1]) -
+                                 (c[0] - a[0]) * (b[1] - a[1]);
+            if (area >= 0)
+            {
+                continue;
+            }
+            triangle_fill(a, b, c, threedee_shade(mesh->normal[face_i]));
+        }
+#else
+        for (uint8_t edge_i = 0; edge_i < mesh->edge_count; ++edge_i)
+        {
+            int16_t const *const a = mesh_screen[mesh->edge[edge_i][0]];
+            int16_t const *const b = mesh_screen[mesh->edge[edge_i][1]];
+            bresenham(FG_LEVEL_MAX, a[0], a[1], b[0], b[1]);
+        }
+#endif
+    }
+}
+
+/* Draws row `_y` of the XOR chess background. */
+static void chess(uint32_t const _frame, uint16_t const _y)
+{
+    const uint32_t delta = _frame / 2;
+    row_dirty_add(_y, _y);
+    span_xor(bg[_y], delta, _y + delta, 0xFF);
+}
+
+/* Size of the plasma sample grid, every sample covers a block of pixels. */
+#define PLASMA_W (VIDEO_W / PLASMA_BLOCK)
+#define PLASMA_H (VIDEO_H / PLASMA_BLOCK)
+
+#if !PLASMA_FIXED_POINT || defined(BENCH)
+/* Distance of every sample from the top left corner, as cosine and sine so
+ * that the frame can be added as a rotation. */
+static float plasma_dist_cos[PLASMA_H + 1][PLASMA_W + 1];
+static float plasma_dist_sin[PLASMA_H + 1][PLASMA_W + 1];
+/* Terms of the plasma that depend only on the frame, the column or the row,
+ * for `plasma_frame`. */
+static uint32_t plasma_frame = UINT32_MAX;
+static float plasma_time_sin, plasma_time_cos;
+static float plasma_col_wave[PLASMA_W + 1];
+static float plasma_col_center[PLASMA_W + 1];
+static float plasma_row_center[PLASMA_H + 1];
+
+static void plasma_create()
+{
+    for (uint16_t _y = 0; _y <= PLASMA_H; ++_y)
+    {
+        for (uint16_t _x = 0; _x <= PLASMA_W; ++_x)
+        {
+            float const dy = (float)(_y * PLASMA_BLOCK) / VIDEO_H;
+            float const dx = (float)(_x * PLASMA_BLOCK) / VIDEO_W;
+            sincosf(sqrtf(dx * dx + dy * dy), &plasma_dist_sin[_y][_x],
+                    &plasma_dist_cos[_y][_x]);
+        }
+    }
+}
+
+static void plasma_terms(uint32_t const _frame)
+{
+    float const time = _frame / 64.0f;
+    float time3_sin, time3_cos;
+    sincosf(time / 3.0f, &time3_sin, &time3_cos);
+    sincosf(time, &plasma_time_sin, &plasma_time_cos);
+
+    for (uint16_t _x = 0; _x <= PLASMA_W; ++_x)
+    {
+        float const dx = (float)(_x * PLASMA_BLOCK) / VIDEO_W;
+        float const cx = dx + time3_sin;
+        plasma_col_wave[_x] = sinf(dx * 10.0f + time);
+        plasma_col_center[_x] = 50.0f * cx * cx;
+    }
+    for (uint16_t _y = 0; _y <= PLASMA_H; ++_y)
+    {
+        float const dy = (float)(_y * PLASMA_BLOCK) / VIDEO_H;
+        float const cy = dy + time3_cos;
+        plasma_row_center[_y] = 50.0f * cy * cy + 1.0f + time;
+    }
+    plasma_frame = _frame;
+}
+
+/* Plasma value of the sample at grid coordinates `sample_y`, `sample_x`. The
+ * grid has a sample past the bottom and right edge of the screen. */
+static float plasma_field(uint32_t const _frame, uint16_t const sample_y,
+                          uint16_t const sample_x)
+{
+    if (_frame != plasma_frame)
+    {
+        plasma_terms(_frame);
+    }
+
+    /* Wave along x, rings around a moving center and rings around the top
+     * left corner moving with time, as cos(dist - time). */
+    float v = plasma_col_wave[sample_x];
+    v += sinf(sqrtf(plasma_col_center[sample_x] + plasma_row_center[sample_y]));
+    v += plasma_dist_cos[sample_y][sample_x] * plasma_time_cos +
+         plasma_dist_sin[sample_y][sample_x] * plasma_time_sin;
+    return v;
+}
+
+/* Color of the sample at grid coordinates `sample_y`, `sample_x`. */
+static inline uint8_t plasma_color(uint32_t const _frame,
+                                   uint16_t const sample_y,
+                                   uint16_t const sample_x)
+{
+    float const v = plasma_field(_frame, sample_y, sample_x);
+    float vpi_sin, vpi_cos;
+    sincosf(v * M_PI, &vpi_sin, &vpi_cos);
+    uint8_t const r = (uint8_t)(vpi_sin * 64.0f);
+    uint8_t const b = (uint8_t)(vpi_cos * 64.0f);
+    return (r + b) % 255;
+}
+#endif
+
+#if PLASMA_FIXED_POINT || defined(BENCH)
+/* Same terms as above in fixed-point. Angles are in the units of plasma.h,
+ * sines in Q14 and the argument of the center rings in Q16. */
+static uint32_t plasma_frame_fixed = UINT32_MAX;
+static uint16_t plasma_time_angle;
+static int16_t plasma_col_wave_fixed[PLASMA_W + 1];
+static uint32_t plasma_col_center_fixed[PLASMA_W + 1];
+static uint32_t plasma_row_center_fixed[PLASMA_H + 1];
+
+/* Sine interpolated between the entries of the table. */
+static inline int16_t plasma_sin_fixed(uint16_t const angle)
+{
+    uint16_t const shift = 16U - PLASMA_SIN_BITS;
+    uint16_t const sin_i = angle >> shift;
+    int32_t const frac = angle & ((1U << shift) - 1U);
+    int32_t const sin_a = plasma_sin[sin_i];
+    int32_t const sin_b =
+        plasma_sin[(sin_i + 1U) & ((1U << PLASMA_SIN_BITS) - 1U)];
+    return sin_a + (((sin_b - sin_a) * frac) >> shift);
+}
+
+static inline int16_t plasma_cos_fixed(uint16_t const angle)
+{
+    return plasma_sin_fixed(angle + (1U << 14));
+}
+
+/* Square root in Q12 of `val` in Q16, with `val` at least 1. The root is
+ * found bit by bit, then refined by a Newton step. */
+static uint32_t plasma_sqrt_fixed(uint32_t const val)
+{
+    uint32_t rem = val;
+    uint32_t root = 0;
+    for (uint32_t bit = 1UL << 30; bit != 0; bit >>= 2)
+    {
+        if (rem >= root + bit)
+        {
+            rem -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+    }
+    return (root << 4) + (rem << 3) / root;
+}
+
+/* Products with the angle units per radian may overflow, as long as they are
+ * not shifted by more than 16 bits the angle wraps correctly. */
+static void plasma_terms_fixed(uint32_t const _frame)
+{
+    /* time is _frame / 64 radians, the rates are in Q12. */
+    plasma_time_angle = (_frame * (PLASMA_ANGLE_RAD_Q8 / 4U)) >> 12;
+    uint16_t const time3_angle = (_frame * (PLASMA_ANGLE_RAD_Q8 / 12U)) >> 12;
+    int32_t const time3_sin = plasma_sin_fixed(time3_angle);
+    int32_t const time3_cos = plasma_cos_fixed(time3_angle);
+
+    for (uint16_t _x = 0; _x <= PLASMA_W; ++_x)
+    {
+        uint32_t const x = _x * PLASMA_BLOCK;
+        /* dx * 10 is x / 16 radians. */
+        uint16_t const wave_angle =
+            ((x * (PLASMA_ANGLE_RAD_Q8 / 16U)) >> 8) + plasma_time_angle;
+        int32_t const cx = (int32_t)((x << PLASMA_SIN_Q) / VIDEO_W) + time3_sin;
+        plasma_col_wave_fixed[_x] = plasma_sin_fixed(wave_angle);
+        plasma_col_center_fixed[_x] = 50U * (uint32_t)((cx * cx) >> 12);
+    }
+    for (uint16_t _y = 0; _y <= PLASMA_H; ++_y)
+    {
+        uint32_t const y = _y * PLASMA_BLOCK;
+        int32_t const cy = (int32_t)((y << PLASMA_SIN_Q) / VIDEO_H) + time3_cos;
+        plasma_row_center_fixed[_y] =
+            50U * (uint32_t)((cy * cy) >> 12) + (1UL << 16) + (_frame << 10);
+    }
+    plasma_frame_fixed = _frame;
+}
+
+/* Plasma value in Q14, like `plasma_field`. */
+static int32_t plasma_field_fixed(uint32_t const _frame,
+                                  uint16_t const sample_y,
+                                  uint16_t const sample_x)
+{
+    if (_frame != plasma_frame_fixed)
+    {
+        plasma_terms_fixed(_frame);
+    }
+
+    uint16_t const center_angle =
+        (plasma_sqrt_fixed(plasma_col_center_fixed[sample_x] +
+                           plasma_row_center_fixed[sample_y]) *
+         (PLASMA_ANGLE_RAD_Q8 / 64U)) >>
+        14;
+    uint16_t const dist =
+        plasma_dist[sample_y * PLASMA_BLOCK][sample_x * PLASMA_BLOCK];
+    return plasma_col_wave_fixed[sample_x] + plasma_sin_fixed(center_angle) +
+           plasma_cos_fixed(dist - plasma_time_angle);
+}
+
+static inline uint8_t plasma_color_fixed(uint32_t const _frame,
+                                         uint16_t const sample_y,
+                                         uint16_t const sample_x)
+{
+    /* v * PI radians is v / 2 turns. */
+    uint16_t const vpi_angle =
+        plasma_field_fixed(_frame, sample_y, sample_x) * 2;
+    /* Truncated towards zero and wrapped, like the float casts. */
+    uint8_t const r = (uint8_t)(plasma_sin_fixed(vpi_angle) / 256);
+    uint8_t const b = (uint8_t)(plasma_cos_fixed(vpi_angle) / 256);
+    return (r + b) % 255;
+}
+#endif
+
+#if PLASMA_BILINEAR
+/* Fills the `size` x `size` pixels of bg at `_y`, `_x` from a field sampled
+ * at the corners of the block, top left `f00`, top right `f01`, bottom left
+ * `f10` and bottom right `f11`. The field is interpolated bilinearly, stepping
+ * in Q8 along the edges and the rows, so its values must stay within 23 bits.
+ * Each value is taken as an angle and its top bits look up the color in
+ * `shade`, which has 1 << `shade_bits` entries. */
+static void bg_bilinear(uint16_t const _y, uint16_t const _x,
+                        uint16_t const size, int32_t const f00,
+                        int32_t const f01, int32_t const f10,
+                        int32_t const f11, uint8_t const *const shade,
+                        uint8_t const shade_bits)
+{
+    int32_t left = f00 << 8;
+    int32_t right = f01 << 8;
+    int32_t const left_step = ((f10 - f00) << 8) / (int32_t)size;
+    int32_t const right_step = ((f11 - f01) << 8) / (int32_t)size;
+
+    for (uint16_t i = 0; i < size; ++i)
+    {
+        uint8_t *const row = &bg[_y + i][_x];
+        int32_t val = left;
+        int32_t const step = (right - left) / (int32_t)size;
+        for (uint16_t j = 0; j < size; ++j)
+        {
+            row[j] = shade[(uint16_t)(val >> 8) >> (16U - shade_bits)];
+            val += step;
+        }
+        left += left_step;
+        right += right_step;
+    }
+}
+
+/* v * PI of every sample as an angle, for `plasma_grid_frame`. */
+static int32_t plasma_grid[PLASMA_H + 1][PLASMA_W + 1];
+static uint32_t plasma_grid_frame = UINT32_MAX;
+
+static void plasma_grid_sample(uint32_t const _frame)
+{
+    for (uint16_t _y = 0; _y <= PLASMA_H; ++_y)
+    {
+        for (uint16_t _x = 0; _x <= PLASMA_W; ++_x)
+        {
+#if PLASMA_FIXED_POINT
+            /* v * PI radians is v / 2 turns. */
+            plasma_grid[_y][_x] = plasma_field_fixed(_frame, _y, _x) * 2;
+#else
+            plasma_grid[_y][_x] =
+                (int32_t)(plasma_field(_frame, _y, _x) * 32768.0f);
+#endif
+        }
+    }
+    plasma_grid_frame = _frame;
+}
+#endif
+
+static void plasma(uint32_t const _frame, uint16_t const _y, uint16_t const _x)
+{
+    uint16_t const sample_y = _y / PLASMA_BLOCK;
+    uint16_t const sample_x = _x / PLASMA_BLOCK;
+    if (_x == 0)
+    {
+        row_dirty_add(_y, _y + PLASMA_BLOCK - 1);
+    }
+#if PLASMA_BILINEAR
+    /* The whole grid is sampled by the first block drawn in a frame, the
+     * blocks need the samples of the next row. */
+    if (_frame != plasma_grid_frame)
+    {
+        plasma_grid_sample(_frame);
+    }
+    bg_bilinear(_y, _x, PLASMA_BLOCK, plasma_grid[sample_y][sample_x],
+                plasma_grid[sample_y][sample_x + 1],
+                plasma_grid[sample_y + 1][sample_x],
+                plasma_grid[sample_y + 1][sample_x + 1], plasma_shade,
+                PLASMA_SHADE_BITS);
+#else
+#if PLASMA_FIXED_POINT
+    uint8_t const color = plasma_color_fixed(_frame, sample_y, sample_x);
+#else
+    uint8_t const color = plasma_color(_frame, sample_y, sample_x);
+#endif
+
+    for (uint8_t i = 0; i < PLASMA_BLOCK; ++i)
+    {
+        for (uint8_t j = 0; j < PLASMA_BLOCK; ++j)
+        {
+            bg[_y + i][_x + j] = color;
+        }
+    }
+#endif
+}
+
+#if FRACTAL_SHADEBOB
+/* The bob follows a Lissajous path and leaves a trail that fades every other
+ * frame. */
+static void fractal_shadebob(uint32_t const _frame)
+{
+    if (_frame % 2 == 0)
+    {
+        fg_fade();
+    }
+    int16_t const x = VIDEO_W_2 + (int16_t)(sinf(_frame * 0.08f) * 30.0f);
+    int16_t const _y = VIDEO_H_2 + (int16_t)(cosf(_frame * 0.10f) * 20.0f);
+    sprite_add(&sprite_bob, x - sprite_bob.w / 2, _y - sprite_bob.h / 2);
+}
+#endif
+
+static void draw(effect_et const _effect, uint32_t const _frame,
+                 uint16_t const _y, uint16_t const _x)
+{
+    switch (_effect)
+    {
+    case EFFECT_START:
+        break;
+    case EFFECT_FIRE_A:
+        fire(_effect, _y, _x);
+        threedee(_effect, _frame, &mesh_cube, _y, _x);
+        break;
+    case EFFECT_FIRE_C:
+    case EFFECT_FIRE_B:
+        if (_y % PLASMA_BLOCK == 0 && _x % PLASMA_BLOCK == 0)
+        {
+            plasma(_frame, _y, _x);
+        }
+        threedee(_effect, _frame, &mesh_gem, _y, _x);
+        break;
+    case EFFECT_WATER:
+        fire(_effect, _y, _x);
+        break;
+    case EFFECT_ACID:
+        fire(_effect, _y, _x);
+        break;
+    case EFFECT_FRACTAL:
+    {
+        /* The offset here is the sum of frame durations from start till
+         * this effect. */
+        uint32_t const frame_rel = (_frame - 1136) + 110;
+#if FRACTAL_SHADEBOB
+        if (_y == 0 && _x == 0)
+        {
+            fractal_shadebob(_frame);
+        }
+#endif
+#if FRACTAL_RENDER == FRACTAL_RENDER_SUBDIVIDE
+        /* A band is rendered when its first row is drawn, ahead of its
+         * composition. The first band is rendered before the first row of the
+         * frame is composed. */
+        if (_x == 0 && (_y == DRAW_AHEAD || (_y > DRAW_AHEAD &&
+                                             _y % (FRACTAL_BAND_H * 2) == 0)))
+        {
+            fractal_band(frame_rel, _y / (FRACTAL_BAND_H * 2) * FRACTAL_BAND_H);
+        }
+#elif FRACTAL_RENDER == FRACTAL_RENDER_STREAM
+        if (_y == DRAW_AHEAD && _x == 0)
+        {
+            fractal_stream_decode(frame_rel);
+        }
+#elif FRACTAL_RENDER == FRACTAL_RENDER_BUDGET
+        /* Bands start on the same rows as in the subdivide render, each with
+         * its share of the time. */
+        if (_x == 0 && (_y == DRAW_AHEAD || (_y > DRAW_AHEAD &&
+                                             _y % (FRACTAL_BAND_H * 2) == 0)))
+        {
+            fractal_budget_band(frame_rel,
+                                _y / (FRACTAL_BAND_H * 2) * FRACTAL_BAND_H);
+        }
+#elif FRACTAL_RENDER == FRACTAL_RENDER_PROGRESSIVE
+        if (_y % 2 == 0 && _x % 2 == 0 &&
+            fractal_sample_due(frame_rel, _y / 2, _x / 2))
+        {
+            fractal_sample(frame_rel, _y / 2, _x / 2);
+        }
+#else
+        if (_y % 2 == 0 && _x % 2 == 0)
+        {
+            fractal_sample(frame_rel, _y / 2, _x / 2);
+        }
+#endif
+        break;
+    }
+    case EFFECT_3D_B:
+        if (_x == 0)
+        {
+            chess(_frame, _y);
+        }
+        if (_frame % 4 == 0)
+        {
+            threedee(_effect, _frame / 4, &mesh_gem, _y, _x);
+        }
+        break;
+    case EFFECT_END:
+        if (_y % PLASMA_BLOCK == 0 && _x % PLASMA_BLOCK == 0)
+        {
+            plasma(_frame, _y, _x);
+        }
+        break;
+    }
+}
+
+/* Blending works on two pixels of a word at once, channel by channel. These
+ * are the bits of all channels, their top bits and their bottom bits. */
+#define BLEND_PAIR(pixel) ((uint32_t)(pixel) * 0x00010001UL)
+#define BLEND_CHANNEL BLEND_PAIR(PICO_SCANVIDEO_PIXEL_FROM_RGB8(255, 255, 255))
+#define BLEND_CHANNEL_HIGH                                                     \
+    BLEND_PAIR(PICO_SCANVIDEO_PIXEL_FROM_RGB8(128, 128, 128))
+#define BLEND_CHANNEL_LOW BLEND_PAIR(PICO_SCANVIDEO_PIXEL_FROM_RGB8(8, 8, 8))
+
+/* Lays `fg_word` over `bg_word`, two pixels each, the levels of fg being
+ * `levels`. `mode` is a constant wherever this is inlined, so every mode
+ * gets its own loop in `blend_row`. */
+static inline __attribute__((always_inline)) uint32_t
+blend_word(blend_et const mode, uint32_t const bg_word, uint32_t const fg_word,
+           uint8_t const levels)
+{
+    /* Pixels with a level of fg, whole. */
+    uint32_t const fg_mask = (((levels & 0xFU) + 0xFU) >> 4) * 0xFFFFU |
+                             (((levels >> 4) + 0xFU) >> 4) * 0xFFFF0000U;
+    switch (mode)
+    {
+    case BLEND_OR:
+        return bg_word | fg_word;
+    case BLEND_ADD: {
+        /* The bits below the top of each channel add without reaching the
+         * next one, the top bit and its carry out follow from the sum. */
+        uint32_t const low = BLEND_CHANNEL & ~BLEND_CHANNEL_HIGH;
+        uint32_t const sum = (bg_word & low) + (fg_word & low);
+        uint32_t const high = (bg_word ^ fg_word ^ sum) & BLEND_CHANNEL_HIGH;
+        uint32_t const carry =
+            ((bg_word & fg_word) | ((bg_word | fg_word) & sum)) &
+            BLEND_CHANNEL_HIGH;
+        /* Channels that carried out are full, they are 5 bits wide. */
+        return (sum & low) | high | carry | (carry - (carry >> 4));
+    }
+    case BLEND_REPLACE:
+        return (bg_word & ~fg_mask) | (fg_word & fg_mask);
+    case BLEND_AVERAGE: {
+        /* Halves of both without the bottom bits, which would shift into the
+         * channel below, plus the bottom bits they share. */
+        uint32_t const average =
+            (bg_word & fg_word) +
+            (((bg_word ^ fg_word) & (BLEND_CHANNEL & ~BLEND_CHANNEL_LOW)) >>
+             1);
+        return (bg_word & ~fg_mask) | (average & fg_mask);
+    }
+    default:
+        __builtin_unreachable();
+    }
+}
+
+/* Composes row `_y` of vid from bg and fg, two pixels per word. */
+static inline __attribute__((always_inline)) void
+blend_row(blend_et const mode, uint16_t const _y)
+{
+    uint32_t *const vid_row = (uint32_t *)vid[_y];
+    uint8_t const *const bg_row = bg[_y];
+    uint8_t const *const fg_row = fg[_y];
+    /* The rows above `DRAW_AHEAD` were drawn at the end of the previous
+     * frame, at its rotation. */
+    uint16_t const *const palette_row =
+        _y < DRAW_AHEAD && palette_offset != palette_offset_prev
+            ? palette_bg_prev
+            : palette_bg;
+    for (uint16_t pair_x = 0; pair_x < VIDEO_W / 2; ++pair_x)
+    {
+        uint8_t const levels = fg_row[pair_x];
+        uint32_t const bg_word = palette_row[bg_row[pair_x * 2]] |
+                                 (uint32_t)palette_row[bg_row[pair_x * 2 + 1]]
+                                     << 16;
+        vid_row[pair_x] = blend_word(mode, bg_word, fg_pair[levels], levels);
+    }
+}
+
+static void scanline(effect_et const _effect, uint32_t const _frame,
+                     uint16_t const _y)
+{
+    for (int x = 0; x < VIDEO_W; ++x)
+    {
+        draw(_effect, _frame, (_y + DRAW_AHEAD) % VIDEO_H, x);
+    }
+    if (!row_dirty[_y])
+    {
+        return;
+    }
+    row_dirty[_y] = false;
+    switch (blend)
+    {
+    case BLEND_OR:
+        blend_row(BLEND_OR, _y);
+        break;
+    case BLEND_ADD:
+        blend_row(BLEND_ADD, _y);
+        break;
+    case BLEND_REPLACE:
+        blend_row(BLEND_REPLACE, _y);
+        break;
+    case BLEND_AVERAGE:
+        blend_row(BLEND_AVERAGE, _y);
+        break;
+    }
+}
+
+/* "Worker thread" for each core. */
+// void __time_critical_func(render_loop)()
+static void render_loop()
+{
+    while (true)
+    {
+        if (y == VIDEO_H)
+        {
+            frame_prologue_done = false;
+            frame_prologue(); // Start next frame.
+        }
+        uint16_t const _y = y++;
+        uint32_t const _frame = frame;
+        effect_et const _effect = effect;
+
+        scanline(_effect, _frame, _y);
+    }
+}
+
+static void fill_scanline_buffer(struct scanvideo_scanline_buffer *const buffer)
+{
+    static uint32_t postamble[] = {0x0000U | (COMPOSABLE_EOL_ALIGN << 16)};
+
+    buffer->data[0] = 4;
+    buffer->data[1] = host_safe_hw_ptr(buffer->data + 8);
+    buffer->data[2] =
+        (VIDEO_W - 4) / 2; /* First four pixels are handled separately. */
+    volatile uint16_t *const pixels =
+        &vid[scanvideo_scanline_number(buffer->scanline_id)][0];
+    buffer->data[3] = host_safe_hw_ptr(pixels + 4);
+    buffer->data[4] = count_of(postamble);
+    buffer->data[5] = host_safe_hw_ptr(postamble);
+    buffer->data[6] = 0;
+    buffer->data[7] = 0;
+    buffer->data_used = 8;
+
+    // 3 pixel run followed by main run, consuming the first 4 pixels.
+    buffer->data[8] = (pixels[0] << 16U) | COMPOSABLE_RAW_RUN;
+    buffer->data[9] = (pixels[1] << 16U) | 0;
+    buffer->data[10] = (COMPOSABLE_RAW_RUN << 16U) | pixels[2];
+    buffer->data[11] =
+        (((VIDEO_W - 3) + 1 - 3) << 16U) |
+        pixels[3]; // Note we add one for the black pixel at the end.
+}
+
+int64_t timer_callback(alarm_id_t const alarm_id, void *const user_data)
+{
+    struct scanvideo_scanline_buffer *buffer =
+        scanvideo_begin_scanline_generation(false);
+    while (buffer)
+    {
+        fill_scanline_buffer(buffer);
+        scanvideo_end_scanline_generation(buffer);
+        buffer = scanvideo_begin_scanline_generation(false);
+    }
+    return 100;
+}
+
+#include "audio_data.h"
+
+static void audio_init()
+{
+    static audio_format_t audio_format = {
+        .format = AUDIO_BUFFER_FORMAT_PCM_S16,
+        .sample_freq = AUDIO_SAMPLE_RATE,
+        .channel_count = 1,
+    };
+
+    static struct audio_buffer_format producer_format = {
+        .format = &audio_format,
+        .sample_stride = 2,
+    };
+
+    audio_buffer_pool =
+        audio_new_producer_pool(&producer_format, 3,
+                                SAMPLES_PER_BUFFER); // todo correct size
+
+    bool __unused ok;
+    const struct audio_format *output_format;
+    struct audio_i2s_config config = {
+        .data_pin = PICO_AUDIO_I2S_DATA_PIN,
+        .clock_pin_base = PICO_AUDIO_I2S_CLOCK_PIN_BASE,
+        .dma_channel = PICO_AUDIO_I2S_DMA_IRQ,
+        .pio_sm = PICO_AUDIO_I2S_PIO,
+    };
+
+    output_format = audio_i2s_setup(&audio_format, &config);
+    if (!output_format)
+    {
+        panic("PicoAudio: Unable to open audio device.\n");
+    }
+
+    ok = audio_i2s_connect(audio_buffer_pool);
+    assert(ok);
+    audio_i2s_set_enabled(true);
+}
+
+/* Read position in the track, in words of `audio_pcm` or bytes of
+ * `audio_adpcm`, and the state of the ADPCM decoder. */
+static uint32_t audio_pos = 0;
+#if AUDIO_ADPCM
+static adpcm_st audio_adpcm_state = {0, 0};
+#endif
+
+/* Writes the next `count` samples of the track into `pairs`, two per word
+ * with the first in the low half. `count` is a multiple of 4, past its end
+ * the track holds its last sample. */
+static void audio_fill(uint32_t *pairs, uint32_t const count)
+{
+#if AUDIO_ADPCM
+    for (uint32_t sample_i = 0; sample_i < count; sample_i += 2)
+    {
+        if (audio_pos < count_of(audio_adpcm))
+        {
+            uint8_t const codes = audio_adpcm[audio_pos++];
+            adpcm_decode(&audio_adpcm_state, codes & 0xFU);
+            uint16_t const first = audio_adpcm_state.sample;
+            adpcm_decode(&audio_adpcm_state, codes >> 4);
+            *pairs++ = first | (uint32_t)(uint16_t)audio_adpcm_state.sample
+                                   << 16;
+        }
+        else
+        {
+            *pairs++ = (uint16_t)audio_adpcm_state.sample * 0x00010001U;
+        }
+    }
+#else
+    /* The last word is held, see tools/audio_gen.c. */
+    uint32_t const word_last = count_of(audio_pcm) - 1;
+    for (uint32_t sample_i = 0; sample_i < count; sample_i += 4)
+    {
+        uint32_t const word = audio_pcm[audio_pos];
+        /* Every 8-bit sample is the high byte of a 16-bit one. */
+        *pairs++ = (word & 0x000000FFU) << 8 | (word & 0x0000FF00U) << 16;
+        *pairs++ = (word & 0x00FF0000U) >> 8 | (word & 0xFF000000U);
+        audio_pos = audio_pos < word_last ? audio_pos + 1 : word_last;
+    }
+#endif
+}
+
+static void core1_func()
+{
+    audio_init();
+
+    while (true)
+    {
+        struct audio_buffer *buffer =
+            take_audio_buffer(audio_buffer_pool, true);
+        audio_fill((uint32_t *)buffer->buffer->bytes,
+                   buffer->max_sample_count);
+        buffer->sample_count = buffer->max_sample_count;
+        give_audio_buffer(audio_buffer_pool, buffer);
+    }
+}
+
+#ifdef BENCH
+/* Cycles elapsed since `start_us`, measured with the microsecond timer. */
+static uint32_t bench_cycles(uint32_t const start_us)
+{
+    return (time_us_32() - start_us) * (clock_get_hz(clk_sys) / 1000000U);
+}
+
+/* A second 8-bit plane to compare kernels against each other, fg only holds
+ * 4-bit levels. */
+static uint8_t bench_scratch[VIDEO_H][VIDEO_W] __attribute__((aligned(4)));
+
+/* Steps every cell of the fire once, in the order `scanline` draws them. The
+ * `baseline` keeps no palette rotation and adds it to each cell in place, as
+ * WATER and ACID did before they drifted through `palette_offset`. */
+static void bench_fire_frame(effect_et const _effect, uint32_t const _frame,
+                             bool const baseline)
+{
+    for (uint32_t rank = 0; rank < VIDEO_H * VIDEO_W; ++rank)
+    {
+        uint16_t const idx =
+            (rank + DRAW_AHEAD * VIDEO_W) % (VIDEO_H * VIDEO_W);
+        if (baseline && _frame % 2 == 0)
+        {
+            bg_idx[idx] = (bg_idx[idx] + 2) % 255;
+        }
+        fire(_effect, idx / VIDEO_W, idx % VIDEO_W);
+    }
+}
+
+/* WATER then ACID as they play in the demo, with and without the palette
+ * rotation, compared cell by cell. The demo starts them from a cleared bg, the
+ * second pass starts from every value in turn so that there are cells at 255
+ * to rotate. */
+static void bench_fire()
+{
+    uint32_t const frame_first = effect_frame_first(EFFECT_WATER);
+    uint32_t const frame_acid = effect_frame_first(EFFECT_ACID);
+    uint32_t const frame_end = effect_frame_first(EFFECT_3D_B);
+    uint8_t *const baseline_idx = &bench_scratch[0][0];
+    uint64_t cycles_baseline = 0;
+    uint64_t cycles_rotated = 0;
+
+    for (uint8_t pass = 0; pass < 2; ++pass)
+    {
+        uint32_t mismatch = 0;
+        uint32_t mismatch_frame = 0;
+        uint8_t offset = 0;
+        for (uint16_t idx = 0; idx < VIDEO_H * VIDEO_W; ++idx)
+        {
+            bg_idx[idx] = pass == 0 ? 0 : idx % 256;
+            baseline_idx[idx] = bg_idx[idx];
+        }
+
+        for (uint32_t _frame = frame_first; _frame < frame_end; ++_frame)
+        {
+            effect_et const _effect =
+                _frame < frame_acid ? EFFECT_WATER : EFFECT_ACID;
+            if (_frame == frame_acid)
+            {
+                for (uint16_t idx = 0; idx < VIDEO_H * VIDEO_W; ++idx)
+                {
+                    bg_idx[idx] = fire_decode(bg_idx[idx], offset) / 2;
+                    baseline_idx[idx] /= 2;
+                }
+                offset = 0;
+            }
+
+            /* bg holds the rotated fire and `bench_scratch` the baseline,
+             * `vid` is not shown yet and swaps them. */
+            palette_offset_prev = offset;
+            if (_frame % 2 == 0)
+            {
+                offset = (offset + 2) % 255;
+            }
+            palette_offset = offset;
+            uint32_t start = time_us_32();
+            bench_fire_frame(_effect, _frame, false);
+            cycles_rotated += bench_cycles(start);
+            memcpy(vid, bg, sizeof(bg));
+
+            memcpy(bg, bench_scratch, sizeof(bg));
+            palette_offset = 0;
+            palette_offset_prev = 0;
+            start = time_us_32();
+            bench_fire_frame(_effect, _frame, true);
+            cycles_baseline += bench_cycles(start);
+            memcpy(bench_scratch, bg, sizeof(bg));
+            memcpy(bg, vid, sizeof(bg));
+
+            uint32_t const mismatch_prev = mismatch;
+            for (uint16_t idx = 0; idx < VIDEO_H * VIDEO_W; ++idx)
+            {
+                mismatch +=
+                    fire_decode(bg_idx[idx], offset) != baseline_idx[idx];
+            }
+            if (mismatch_prev == 0 && mismatch != 0)
+            {
+                mismatch_frame = _frame;
+            }
+        }
+
+        printf("fire rotated vs baseline from %s, frames %lu to %lu: %lu "
+               "cells differ, first in frame %lu\n",
+               pass == 0 ? "a cleared bg" : "every value", frame_first,
+               frame_end - 1, mismatch, mismatch_frame);
+    }
+
+    printf("fire baseline: %lu cycles/frame\n",
+           (uint32_t)(cycles_baseline / ((frame_end - frame_first) * 2)));
+    printf("fire rotated: %lu cycles/frame\n",
+           (uint32_t)(cycles_rotated / ((frame_end - frame_first) * 2)));
+
+    palette_offset = 0;
+    palette_offset_prev = 0;
+    memset(bg, 0, sizeof(bg));
+    memset(vid, 0, sizeof(vid));
+}
+
+/* Swaps the fire in bg with the one in `bench_scratch`. */
+static void bench_fire_swap()
+{
+    uint8_t *const other_idx = &bench_scratch[0][0];
+    for (uint16_t idx = 0; idx < VIDEO_H * VIDEO_W; ++idx)
+    {
+        uint8_t const val = bg_idx[idx];
+        bg_idx[idx] = other_idx[idx];
+        other_idx[idx] = val;
+    }
+}
+
+/* WATER then ACID composed by `scanline` as in the demo, against the baseline
+ * fire drawn and composed row by row in the same order, with its cells
+ * incremented in place and looked up in `palette_list`. Compares the colors
+ * of every composed pixel. */
+static void bench_fire_composed()
+{
+    uint32_t const frame_first = effect_frame_first(EFFECT_WATER);
+    uint32_t const frame_acid = effect_frame_first(EFFECT_ACID);
+    uint32_t const frame_end = effect_frame_first(EFFECT_3D_B);
+    uint8_t *const baseline_idx = &bench_scratch[0][0];
+    uint32_t mismatch = 0;
+    uint32_t mismatch_frame = 0;
+
+    memset(bg, 0, sizeof(bg));
+    memset(fg, 0, sizeof(fg));
+    memset(bench_scratch, 0, sizeof(bench_scratch));
+    for (uint32_t _frame = frame_first; _frame < frame_end; ++_frame)
+    {
+        effect_et const _effect =
+            _frame < frame_acid ? EFFECT_WATER : EFFECT_ACID;
+        if (_frame == frame_acid)
+        {
+            for (uint16_t idx = 0; idx < VIDEO_H * VIDEO_W; ++idx)
+            {
+                bg_idx[idx] = fire_decode(bg_idx[idx], palette_offset) / 2;
+                baseline_idx[idx] /= 2;
+            }
+            palette_offset = 0;
+        }
+
+        /* As `frame_prologue` does. */
+        palette = effect_palette[_effect];
+        palette_offset_prev = palette_offset;
+        if (_frame % 2 == 0)
+        {
+            palette_offset = (palette_offset + 2) % 255;
+        }
+        palette_rotate();
+        row_dirty_add(0, VIDEO_H - 1);
+        for (uint16_t _y = 0; _y < VIDEO_H; ++_y)
+        {
+            scanline(_effect, _frame, _y);
+        }
+
+        uint8_t const offset = palette_offset;
+        uint8_t const offset_prev = palette_offset_prev;
+        palette_offset = 0;
+        palette_offset_prev = 0;
+        bench_fire_swap();
+        uint32_t const mismatch_prev = mismatch;
+        for (uint16_t _y = 0; _y < VIDEO_H; ++_y)
+        {
+            uint16_t const row = (_y + DRAW_AHEAD) % VIDEO_H;
+            for (uint16_t _x = 0; _x < VIDEO_W; ++_x)
+            {
+                if (_frame % 2 == 0)
+                {
+                    bg[row][_x] = (bg[row][_x] + 2) % 255;
+                }
+                fire(_effect, row, _x);
+            }
+            for (uint16_t _x = 0; _x < VIDEO_W; ++_x)
+            {
+                /* A 255 was looked up past the end of its palette. */
+                uint8_t const val = bg[_y][_x];
+                uint16_t const color = val < 255
+                                           ? palette_list[palette][val]
+                                           : palette_list[palette + 1][0];
+                mismatch += color != vid[_y][_x];
+            }
+        }
+        bench_fire_swap();
+        palette_offset = offset;
+        palette_offset_prev = offset_prev;
+        if (mismatch_prev == 0 && mismatch != 0)
+        {
+            mismatch_frame = _frame;
+        }
+    }
+
+    printf("fire composed vs baseline, frames %lu to %lu: %lu pixels differ, "
+           "first in frame %lu\n",
+           frame_first, frame_end - 1, mismatch, mismatch_frame);
+
+    palette = 0;
+    palette_offset = 0;
+    palette_offset_prev = 0;
+    palette_rotate();
+    memset(bg, 0, sizeof(bg));
+    memset(vid, 0, sizeof(vid));
+}
+
+static void bench_fractal()
+{
+    /* The effect is cleared when it starts, so its buffers hold the
+     * iterations of both kernels meanwhile. */
+    uint8_t(*const iteration_float)[VIDEO_W] = bg;
+    uint8_t(*const iteration_fixed)[VIDEO_W] = bench_scratch;
+    uint64_t cycles_float = 0;
+    uint64_t cycles_fixed = 0;
+    uint32_t mismatch = 0;
+    uint8_t mismatch_max = 0;
+
+    for (uint32_t frame_rel = FRACTAL_FRAME_REL_FIRST;
+         frame_rel < FRACTAL_FRAME_REL_FIRST + FRACTAL_FRAME_COUNT; ++frame_rel)
+    {
+        float const imaginary_c = fractal_imaginary_c(frame_rel);
+
+        uint32_t start = time_us_32();
+        for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+            {
+                iteration_float[_y][_x] = fractal_iterate(
+                    imaginary_c, _y, _x, FRACTAL_ITERATION_MAX);
+            }
+        }
+        cycles_float += bench_cycles(start);
+
+        start = time_us_32();
+        int32_t const imaginary_c_fixed = fractal_to_fixed(imaginary_c);
+        for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+            {
+                iteration_fixed[_y][_x] = fractal_iterate_fixed(
+                    imaginary_c_fixed, _y, _x, FRACTAL_ITERATION_MAX);
+            }
+        }
+        cycles_fixed += bench_cycles(start);
+
+        for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+            {
+                uint8_t const delta =
+                    abs(iteration_float[_y][_x] - iteration_fixed[_y][_x]);
+                mismatch += delta != 0;
+                mismatch_max = delta > mismatch_max ? delta : mismatch_max;
+            }
+        }
+    }
+
+    printf("fractal float: %lu cycles/frame\n",
+           (uint32_t)(cycles_float / FRACTAL_FRAME_COUNT));
+    printf("fractal fixed Q%d: %lu cycles/frame\n", FRACTAL_Q,
+           (uint32_t)(cycles_fixed / FRACTAL_FRAME_COUNT));
+    printf("fractal fixed vs float: %lu of %lu samples differ, by up to %u "
+           "iterations\n",
+           mismatch, (uint32_t)(FRACTAL_W * FRACTAL_H * FRACTAL_FRAME_COUNT),
+           mismatch_max);
+
+    memset(bg, 0, sizeof(bg));
+    memset(fg, 0, sizeof(fg));
+}
+
+#if FRACTAL_RENDER == FRACTAL_RENDER_SUBDIVIDE
+/* Subdivision against brute force, with the kernel the demo uses. */
+static void bench_fractal_subdivide()
+{
+    uint64_t cycles_brute = 0;
+    uint64_t cycles_subdivide = 0;
+    uint32_t samples = 0;
+    uint32_t mismatch = 0;
+
+    for (uint32_t frame_rel = FRACTAL_FRAME_REL_FIRST;
+         frame_rel < FRACTAL_FRAME_REL_FIRST + FRACTAL_FRAME_COUNT; ++frame_rel)
+    {
+        uint32_t start = time_us_32();
+        for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+            {
+                fractal_sample(frame_rel, _y, _x);
+            }
+        }
+        cycles_brute += bench_cycles(start);
+        memcpy(bench_scratch, bg, sizeof(bg));
+
+        fractal_sample_count = 0;
+        start = time_us_32();
+        for (uint16_t y0 = 0; y0 < FRACTAL_H - 1; y0 += FRACTAL_BAND_H)
+        {
+            fractal_band(frame_rel, y0);
+        }
+        cycles_subdivide += bench_cycles(start);
+        samples += fractal_sample_count;
+
+        for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+            {
+                mismatch += bg[_y * 2][_x * 2] != bench_scratch[_y * 2][_x * 2];
+            }
+        }
+    }
+
+    printf("fractal brute force: %lu cycles/frame, %lu samples/frame\n",
+           (uint32_t)(cycles_brute / FRACTAL_FRAME_COUNT),
+           (uint32_t)(FRACTAL_W * FRACTAL_H));
+    printf("fractal subdivide: %lu cycles/frame, %lu samples/frame\n",
+           (uint32_t)(cycles_subdivide / FRACTAL_FRAME_COUNT),
+           samples / FRACTAL_FRAME_COUNT);
+    printf("fractal subdivide vs brute force: %lu of %lu samples differ\n",
+           mismatch, (uint32_t)(FRACTAL_W * FRACTAL_H * FRACTAL_FRAME_COUNT));
+
+    memset(bg, 0, sizeof(bg));
+    memset(fg, 0, sizeof(fg));
+}
+#endif
+
+#if FRACTAL_RENDER == FRACTAL_RENDER_PROGRESSIVE
+/* Progressive render against computing every sample in each frame. The error
+ * is the mean absolute color difference of the stale samples. */
+static void bench_fractal_progressive()
+{
+    uint64_t cycles = 0;
+    uint32_t samples = 0;
+    uint32_t mismatch = 0;
+    uint32_t error = 0;
+
+    for (uint32_t frame_rel = FRACTAL_FRAME_REL_FIRST;
+         frame_rel < FRACTAL_FRAME_REL_FIRST + FRACTAL_FRAME_COUNT; ++frame_rel)
+    {
+        fractal_sample_count = 0;
+        uint32_t const start = time_us_32();
+        for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+            {
+                if (fractal_sample_due(frame_rel, _y, _x))
+                {
+                    fractal_sample(frame_rel, _y, _x);
+                }
+            }
+        }
+        cycles += bench_cycles(start);
+        samples += fractal_sample_count;
+
+        for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+            {
+                uint8_t const delta = abs(bg[_y * 2][_x * 2] -
+                                          fractal_color(frame_rel, _y, _x));
+                mismatch += delta != 0;
+                error += delta;
+            }
+        }
+    }
+
+    printf("fractal progressive, %u phases: %lu cycles/frame, %lu "
+           "samples/frame\n",
+           FRACTAL_PHASES, (uint32_t)(cycles / FRACTAL_FRAME_COUNT),
+           samples / FRACTAL_FRAME_COUNT);
+    printf("fractal progressive vs every sample: %lu of %lu samples differ, "
+           "mean error %lu/1000 colors\n",
+           mismatch, (uint32_t)(FRACTAL_W * FRACTAL_H * FRACTAL_FRAME_COUNT),
+           (uint32_t)((uint64_t)error * 1000U /
+                      (FRACTAL_W * FRACTAL_H * FRACTAL_FRAME_COUNT)));
+
+    memset(bg, 0, sizeof(bg));
+}
+#endif
+
+#if FRACTAL_RENDER == FRACTAL_RENDER_STREAM
+/* Stream decoding against rendering with the kernel. */
+static void bench_fractal_stream()
+{
+    uint64_t cycles = 0;
+    uint32_t mismatch = 0;
+
+    for (uint32_t frame_rel = FRACTAL_FRAME_REL_FIRST;
+         frame_rel < FRACTAL_FRAME_REL_FIRST + FRACTAL_FRAME_COUNT; ++frame_rel)
+    {
+        uint32_t const start = time_us_32();
+        fractal_stream_decode(frame_rel);
+        cycles += bench_cycles(start);
+
+        for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+            {
+                mismatch += bg[_y * 2][_x * 2] !=
+                            fractal_color(frame_rel, _y, _x);
+            }
+        }
+    }
+
+    printf("fractal stream: %lu cycles/frame, %lu bytes\n",
+           (uint32_t)(cycles / FRACTAL_FRAME_COUNT),
+           (uint32_t)sizeof(fractal_stream));
+    printf("fractal stream vs kernel: %lu of %lu samples differ\n", mismatch,
+           (uint32_t)(FRACTAL_W * FRACTAL_H * FRACTAL_FRAME_COUNT));
+
+    memset(bg, 0, sizeof(bg));
+}
+#endif
+
+#if FRACTAL_RENDER == FRACTAL_RENDER_BUDGET
+/* Budget render against computing every sample in each frame, band by band
+ * as the frame is drawn. */
+static void bench_fractal_budget()
+{
+    uint64_t cycles = 0;
+    uint32_t band_us_max = 0;
+    uint32_t samples = 0;
+    uint32_t mismatch = 0;
+
+    for (uint32_t frame_rel = FRACTAL_FRAME_REL_FIRST;
+         frame_rel < FRACTAL_FRAME_REL_FIRST + FRACTAL_FRAME_COUNT; ++frame_rel)
+    {
+        fractal_sample_count = 0;
+        for (uint16_t y0 = 0; y0 < FRACTAL_H; y0 += FRACTAL_BAND_H)
+        {
+            uint32_t const start = time_us_32();
+            fractal_budget_band(frame_rel, y0);
+            uint32_t const band_us = time_us_32() - start;
+            cycles += band_us * (clock_get_hz(clk_sys) / 1000000U);
+            band_us_max = band_us > band_us_max ? band_us : band_us_max;
+        }
+        samples += fractal_sample_count;
+
+        for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+            {
+                mismatch += bg[_y * 2][_x * 2] !=
+                            fractal_color(frame_rel, _y, _x);
+            }
+        }
+    }
+
+    printf("fractal budget %luus: %lu cycles/frame, %lu samples/frame\n",
+           (uint32_t)FRACTAL_BUDGET_US,
+           (uint32_t)(cycles / FRACTAL_FRAME_COUNT),
+           samples / FRACTAL_FRAME_COUNT);
+    printf("fractal budget band: %luus at most, %luus allowed\n", band_us_max,
+           (uint32_t)(FRACTAL_BUDGET_US / FRACTAL_BAND_COUNT));
+    printf("fractal budget vs every sample: %lu of %lu samples differ\n",
+           mismatch, (uint32_t)(FRACTAL_W * FRACTAL_H * FRACTAL_FRAME_COUNT));
+
+    memset(bg, 0, sizeof(bg));
+    memset(fractal_capped, 0, sizeof(fractal_capped));
+    memset(fractal_coarse_idx, 0, sizeof(fractal_coarse_idx));
+    memset(fractal_refine_idx, 0, sizeof(fractal_refine_idx));
+}
+#endif
+
+/* Integer plasma against the float one over the frames it is shown in. */
+static void bench_plasma()
+{
+    uint32_t const frame_first = 1268;
+    uint32_t const frame_count = 1000;
+    uint64_t cycles_float = 0;
+    uint64_t cycles_fixed = 0;
+    uint32_t mismatch = 0;
+    uint8_t mismatch_max = 0;
+
+    for (uint32_t _frame = frame_first; _frame < frame_first + frame_count;
+         ++_frame)
+    {
+        uint32_t start = time_us_32();
+        for (uint16_t _y = 0; _y < PLASMA_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < PLASMA_W; ++_x)
+            {
+                bg[_y][_x] = plasma_color(_frame, _y, _x);
+            }
+        }
+        cycles_float += bench_cycles(start);
+
+        start = time_us_32();
+        for (uint16_t _y = 0; _y < PLASMA_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < PLASMA_W; ++_x)
+            {
+                bench_scratch[_y][_x] = plasma_color_fixed(_frame, _y, _x);
+            }
+        }
+        cycles_fixed += bench_cycles(start);
+
+        for (uint16_t _y = 0; _y < PLASMA_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < PLASMA_W; ++_x)
+            {
+                /* Colors wrap around, so the shorter way is the distance. */
+                uint8_t delta = bg[_y][_x] - bench_scratch[_y][_x];
+                delta = delta > 128 ? 256 - delta : delta;
+                mismatch += delta != 0;
+                mismatch_max = delta > mismatch_max ? delta : mismatch_max;
+            }
+        }
+    }
+
+    printf("plasma float: %lu cycles/frame\n",
+           (uint32_t)(cycles_float / frame_count));
+    printf("plasma fixed: %lu cycles/frame\n",
+           (uint32_t)(cycles_fixed / frame_count));
+    printf("plasma fixed vs float, %ux%u samples: %lu of %lu differ, by up to "
+           "%u\n",
+           PLASMA_W, PLASMA_H, mismatch,
+           (uint32_t)(PLASMA_W * PLASMA_H * frame_count), mismatch_max);
+
+#if PLASMA_BILINEAR
+    /* Whole frames as drawn, sampling included. */
+    uint64_t cycles_bilinear = 0;
+    for (uint32_t _frame = frame_first; _frame < frame_first + frame_count;
+         ++_frame)
+    {
+        uint32_t const start = time_us_32();
+        for (uint16_t _y = 0; _y < VIDEO_H; _y += PLASMA_BLOCK)
+        {
+            for (uint16_t _x = 0; _x < VIDEO_W; _x += PLASMA_BLOCK)
+            {
+                plasma(_frame, _y, _x);
+            }
         }
+        cycles_bilinear += bench_cycles(start);
     }
+    printf("plasma bilinear: %lu cycles/frame\n",
+           (uint32_t)(cycles_bilinear / frame_count));
+#endif
+
+    memset(bg, 0, sizeof(bg));
+    memset(fg, 0, sizeof(fg));
 }
 
 static void matrix_mult(float *const o, float const i[3], float const m[4][4])
@@ -516,425 +3023,441 @@ static void matrix_mult(float *const o, float const i[3], float const m[4][4])
     }
 }
 
-static void bresenham(uint16_t const color, uint32_t x0, uint32_t y0,
-                      uint32_t x1, uint32_t y1)
-{
-    int16_t dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
-    int16_t dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
-    int16_t err = dx + dy, e2; /* error value e_xy */
-
-    for (;;)
-    {
-        uint16_t const idx = yx_to_idx(y0, x0);
-        fg_idx[idx] = color;
-
-        if (x0 == x1 && y0 == y1)
-        {
-            break;
-        }
-        e2 = 2 * err;
-        if (e2 >= dy)
-        {
-            err += dy;
-            x0 += sx;
-        } /* e_xy+e_x > 0 */
-        if (e2 <= dx)
-        {
-            err += dx;
-            y0 += sy;
-        } /* e_xy+e_y < 0 */
-    }
-}
-
-inline static void triangle(uint16_t const tri[3][2], uint16_t const color)
+/* Projection of a vertex before the transform was concatenated, in float. */
+static void threedee_project_float(float const vertex[3],
+                                   float const rot_z[4][4],
+                                   float const rot_x[4][4], float const move_x,
+                                   float const move_y, int16_t o[2])
 {
-    bresenham(color, tri[0][0], tri[0][1], tri[1][0], tri[1][1]);
-    bresenham(color, tri[1][0], tri[1][1], tri[2][0], tri[2][1]);
-    bresenham(color, tri[2][0], tri[2][1], tri[0][0], tri[0][1]);
+    float rotate_z[3];
+    float rotate_zx[3];
+    float project[3];
+    matrix_mult(rotate_z, vertex, rot_z);
+    matrix_mult(rotate_zx, rotate_z, rot_x);
+    rotate_zx[2] += 3.0f;
+    matrix_mult(project, rotate_zx, threedee_projection);
+    o[0] = (int16_t)((project[0] + 1) * (float)VIDEO_W_2 + move_x);
+    o[1] = (int16_t)((project[1] + 1) * (float)VIDEO_H_2 + move_y);
 }
 
-static void threedee(effect_et const _effect, uint32_t const _frame,
-                     uint8_t const shape, uint16_t const color,
-                     uint16_t const _y, uint16_t const _x)
+/* Fixed-point vertex transform against the float one, over every frame of
+ * each effect that draws a mesh, and one frame on either side. */
+static void bench_threedee()
 {
-    if (_y == 0 && _x == 0)
+    static struct
     {
-        static float const near_clip = 1.0f;
-        static float const far_clip = 100.0f;
-        static float const fov_rad = 1.0f;
-        static float const aspect_ratio = (float)VIDEO_H / (float)VIDEO_W;
-        static float const projection[4][4] = {
-            {aspect_ratio * fov_rad, 0, 0, 0},
-            {0, fov_rad, 0, 0},
-            {0, 0, far_clip / (far_clip - near_clip), 1.0f},
-            {0, 0, (-far_clip * near_clip) / (far_clip - near_clip), 0}};
-
-        float rot_z[4][4] = {
-            {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}};
-        float rot_x[4][4] = {
-            {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}};
-
-        float const theta = _frame / 8.0f;
+        char const *name;
+        effect_et effect;
+        mesh_st const *mesh;
+        /* 3D_B draws on every fourth frame, at a quarter of the frame. */
+        uint8_t frame_div;
+    } const shapes[] = {
+        {"3D_B gem", EFFECT_3D_B, &mesh_gem, 4},
+        {"FIRE_A cube", EFFECT_FIRE_A, &mesh_cube, 1},
+        {"FIRE_B gem", EFFECT_FIRE_B, &mesh_gem, 1},
+        {"FIRE_C gem", EFFECT_FIRE_C, &mesh_gem, 1},
+    };
+    uint64_t cycles_float = 0;
+    uint64_t cycles_fixed = 0;
+    uint32_t vertex_total = 0;
 
-        for (uint16_t __y = 0; __y < VIDEO_H; ++__y)
+    for (uint8_t shape_i = 0; shape_i < sizeof(shapes) / sizeof(shapes[0]);
+         ++shape_i)
+    {
+        effect_et const _effect = shapes[shape_i].effect;
+        mesh_st const *const mesh = shapes[shape_i].mesh;
+        uint32_t const frame_first = effect_frame_first(_effect) - 1;
+        uint32_t const frame_end =
+            effect_frame_first(_effect) + effect_duration[_effect] + 1;
+        uint32_t vertex_count = 0;
+        uint32_t mismatch = 0;
+        uint16_t mismatch_max = 0;
+
+        for (uint32_t _frame = frame_first; _frame < frame_end; ++_frame)
         {
-            for (uint16_t __x = 0; __x < VIDEO_W; ++__x)
+            if (_frame % shapes[shape_i].frame_div != 0)
             {
-                fg[__y][__x] /= 2;
+                continue;
             }
-        }
-
-        float theta_sin, theta_cos;
-        sincosf(theta, &theta_sin, &theta_cos);
-
-        float theta_half_sin, theta_half_cos;
-        sincosf(theta * 0.5f, &theta_half_sin, &theta_half_cos);
-
-        rot_z[0][0] = theta_cos;
-        rot_z[0][1] = theta_sin;
-        rot_z[1][0] = -theta_sin;
-        rot_z[1][1] = theta_cos;
-        rot_z[2][2] = 1;
-        rot_z[3][3] = 1;
-        if (_effect == EFFECT_3D_B || _effect == EFFECT_FIRE_C)
-        {
-            rot_z[0][1] = -theta_half_sin;
-        }
-
-        rot_x[0][0] = 1;
-        rot_x[1][1] = theta_half_cos;
-        rot_x[1][2] = theta_half_sin;
-        rot_x[2][1] = -theta_half_sin;
-        rot_x[2][2] = theta_half_cos;
-        rot_x[3][3] = 1;
-
-        for (uint8_t tri_i = 0;
-             tri_i < (shape == 0 ? vertex_cube_count : vertex_gem_count);
-             ++tri_i)
-        {
-            float tri[3][3];
-            for (uint8_t i = 0; i < 3; ++i)
+            float const theta = _frame / shapes[shape_i].frame_div / 8.0f;
+            float rot_z[4][4];
+            float rot_x[4][4];
+            threedee_rotation(_effect, theta, rot_z, rot_x);
+            float move_x, move_y;
+            threedee_move(theta, &move_x, &move_y);
+            threedee_matrix_create(_effect, theta);
+
+            for (uint8_t vertex_i = 0; vertex_i < mesh->vertex_count;
+                 ++vertex_i)
             {
-                for (uint8_t j = 0; j < 3; ++j)
+                int16_t const *const vertex = mesh->vertex[vertex_i];
+                float const vertex_float[3] = {vertex[0] / 128.0f,
+                                               vertex[1] / 128.0f,
+                                               vertex[2] / 128.0f};
+                int16_t o_float[2];
+                int16_t o_fixed[2];
+
+                uint32_t start = time_us_32();
+                threedee_project_float(vertex_float, rot_z, rot_x, move_x,
+                                       move_y, o_float);
+                cycles_float += bench_cycles(start);
+
+                start = time_us_32();
+                threedee_project(vertex, o_fixed);
+                cycles_fixed += bench_cycles(start);
+
+                for (uint8_t k = 0; k < 2; ++k)
                 {
-                    switch (shape)
-                    {
-                    case 0:
-                        tri[i][j] = (float)vertex_cube[tri_i][i][j];
-                        break;
-                    case 1:
-                        tri[i][j] = (float)vertex_gem[tri_i][i][j] / 128.0f;
-                        break;
-                    default:
-                        __builtin_unreachable();
-                    }
+                    uint16_t const delta = abs(o_float[k] - o_fixed[k]);
+                    mismatch += delta != 0;
+                    mismatch_max = delta > mismatch_max ? delta : mismatch_max;
                 }
+                ++vertex_count;
             }
+        }
+        vertex_total += vertex_count;
 
-            float tri_project[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-            float tri_translate[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-            float tri_rotate_z[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-            float tri_rotate_zx[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-
-            // Rotate in Z-Axis
-            matrix_mult(tri_rotate_z[0], tri[0], rot_z);
-            matrix_mult(tri_rotate_z[1], tri[1], rot_z);
-            matrix_mult(tri_rotate_z[2], tri[2], rot_z);
-
-            // Rotate in X-Axis
-            matrix_mult(tri_rotate_zx[0], tri_rotate_z[0], rot_x);
-            matrix_mult(tri_rotate_zx[1], tri_rotate_z[1], rot_x);
-            matrix_mult(tri_rotate_zx[2], tri_rotate_z[2], rot_x);
-
-            // Offset into the screen
-            memcpy(tri_translate, tri_rotate_zx, sizeof(tri_translate));
-            tri_translate[0][2] = tri_rotate_zx[0][2] + 3.0f;
-            tri_translate[1][2] = tri_rotate_zx[1][2] + 3.0f;
-            tri_translate[2][2] = tri_rotate_zx[2][2] + 3.0f;
+        printf("threedee %s fixed vs float: %lu of %lu coordinates differ, "
+               "by up to %u\n",
+               shapes[shape_i].name, mismatch, vertex_count * 2,
+               mismatch_max);
+    }
 
-            // Project triangles from 3D --> 2D
-            matrix_mult(tri_project[0], tri_translate[0], projection);
-            matrix_mult(tri_project[1], tri_translate[1], projection);
-            matrix_mult(tri_project[2], tri_translate[2], projection);
+    printf("threedee float: %lu cycles/vertex\n",
+           (uint32_t)(cycles_float / vertex_total));
+    printf("threedee fixed: %lu cycles/vertex\n",
+           (uint32_t)(cycles_fixed / vertex_total));
+}
 
-            // Scale into view
-            float const video_w_half = (float)VIDEO_W_2;
-            float const video_h_half = (float)VIDEO_H_2;
-            tri_project[0][0] += 1;
-            tri_project[0][1] += 1;
-            tri_project[1][0] += 1;
-            tri_project[1][1] += 1;
-            tri_project[2][0] += 1;
-            tri_project[2][1] += 1;
-            tri_project[0][0] *= video_w_half;
-            tri_project[0][1] *= video_h_half;
-            tri_project[1][0] *= video_w_half;
-            tri_project[1][1] *= video_h_half;
-            tri_project[2][0] *= video_w_half;
-            tri_project[2][1] *= video_h_half;
+/* The credits of END drawn glyph by glyph against drawn from the cache. */
+static void bench_text()
+{
+    static char const *const credits[5] = {
+        "DECRUNCH  2023", "     WILD     ", "   RPI PICO   ",
+        " CODE: 1935711", "MUSIC: EIGHTBM",
+    };
+    /* The credits are the last captions added by `overlay_create`. */
+    overlay_st const *const credit = &overlay[overlay_count - 5U];
+    uint32_t const frame_count = 100;
+    uint64_t cycles_draw = 0;
+    uint64_t cycles_cached = 0;
+    uint64_t cycles_overlay = 0;
+
+    for (uint32_t _frame = 0; _frame < frame_count; ++_frame)
+    {
+        uint32_t start = time_us_32();
+        for (uint8_t line_i = 0; line_i < 5; ++line_i)
+        {
+            text_draw(credit[line_i].text.y, 46, 1, credits[line_i], 14,
+                      FG_LEVEL_MAX);
+        }
+        cycles_draw += bench_cycles(start);
 
-            uint16_t tri_draw[3][2] = {{0, 0}, {0, 0}, {0, 0}};
-            float theta_1p4_sin, theta_1p4_cos;
-            sincosf(theta * 1.4f, &theta_1p4_sin, &theta_1p4_cos);
-            float const move_x = theta_sin * 35.0f;
-            float const move_y = theta_1p4_cos * 20.0f;
-            for (uint8_t tri_row_i = 0; tri_row_i < 3; ++tri_row_i)
-            {
-                tri_draw[tri_row_i][0] =
-                    (uint16_t)(tri_project[tri_row_i][0] + move_x);
-                tri_draw[tri_row_i][1] =
-                    (uint16_t)(tri_project[tri_row_i][1] + move_y);
-            }
-            triangle(tri_draw, color);
+        start = time_us_32();
+        for (uint8_t line_i = 0; line_i < 5; ++line_i)
+        {
+            text_cached_draw(&credit[line_i].text);
         }
+        cycles_cached += bench_cycles(start);
     }
-}
 
-static void chess(uint32_t const _frame, uint16_t const _y, uint16_t const _x)
-{
-    const uint32_t delta = _frame / 2;
-    bg[_y][_x] = (((_x + delta)) ^ (_y + delta)) - 1;
+    memcpy(bench_scratch, fg, sizeof(fg));
+    memset(fg, 0, sizeof(fg));
+    for (uint32_t _frame = 0; _frame < frame_count; ++_frame)
+    {
+        uint32_t const start = time_us_32();
+        overlay_update(credit->frame_first + _frame);
+        cycles_overlay += bench_cycles(start);
+    }
+    /* Both hold fg as packed bytes. */
+    uint8_t const *const drawn = &bench_scratch[0][0];
+    uint8_t const *const overlaid = &fg[0][0];
+    uint32_t mismatch = 0;
+    for (uint32_t byte_i = 0; byte_i < sizeof(fg); ++byte_i)
+    {
+        mismatch += drawn[byte_i] != overlaid[byte_i];
+    }
+    memset(fg, 0, sizeof(fg));
+    overlay_invalidate();
+
+    printf("text draw: %lu cycles/frame\n",
+           (uint32_t)(cycles_draw / frame_count));
+    printf("text cached: %lu cycles/frame\n",
+           (uint32_t)(cycles_cached / frame_count));
+    printf("text overlay: %lu cycles/frame\n",
+           (uint32_t)(cycles_overlay / frame_count));
+    printf("text overlay vs draw: %lu pixel pairs differ\n", mismatch);
 }
 
-static void plasma(uint32_t const _frame, uint16_t const _y, uint16_t const _x)
+/* The bob drawn and added at every word alignment, a quarter of the draws
+ * clipped by the left edge of the screen. */
+static void bench_sprite()
 {
-    float const time = _frame / 64.0f;
-    float const dy = (float)_y / VIDEO_H;
-    float const dx = (float)_x / VIDEO_W;
-    float v = sinf(dx * 10.0f + time);
-    float time3_sin, time3_cos;
-    sincosf(time / 3.0f, &time3_sin, &time3_cos);
-    float const cx = dx + time3_sin;
-    float const cy = dy + time3_cos;
-    v += sinf(sqrtf(50.0f * (cx * cx + cy * cy) + 1.0f + time));
-    v += cosf(sqrtf(dx * dx + dy * dy) - time);
-    float vpi_sin, vpi_cos;
-    sincosf(v * M_PI, &vpi_sin, &vpi_cos);
-    uint8_t const r = (uint8_t)(vpi_sin * 64.0f);
-    uint8_t const b = (uint8_t)(vpi_cos * 64.0f);
-    uint8_t const color = (r + b) % 255;
+    uint32_t const draw_count = 160;
+    uint64_t cycles_draw = 0;
+    uint64_t cycles_add = 0;
 
-    for (uint8_t i = 0; i < 4; ++i)
+    for (uint32_t draw_i = 0; draw_i < draw_count; ++draw_i)
     {
-        for (uint8_t j = 0; j < 4; ++j)
-        {
-            bg[_y + i][_x + j] = color;
-        }
+        int16_t const x = (int16_t)(draw_i % 16U) - 4;
+        int16_t const _y = (int16_t)(draw_i % VIDEO_H);
+        uint32_t start = time_us_32();
+        sprite_draw(&sprite_bob, x, _y);
+        cycles_draw += bench_cycles(start);
+
+        start = time_us_32();
+        sprite_add(&sprite_bob, x, _y);
+        cycles_add += bench_cycles(start);
     }
+    memset(fg, 0, sizeof(fg));
+
+    printf("sprite %ux%u draw: %lu cycles\n", sprite_bob.w, sprite_bob.h,
+           (uint32_t)(cycles_draw / draw_count));
+    printf("sprite %ux%u add: %lu cycles\n", sprite_bob.w, sprite_bob.h,
+           (uint32_t)(cycles_add / draw_count));
 }
 
-static void draw(effect_et const _effect, uint32_t const _frame,
-                 uint16_t const _y, uint16_t const _x)
+/* Fills every row of bench_scratch with one of the span generators, with the
+ * parameters changing from row to row. */
+static void bench_span_fill(uint8_t const kind)
 {
-    switch (_effect)
+    for (uint16_t _y = 0; _y < VIDEO_H; ++_y)
     {
-    case EFFECT_START:
-        break;
-    case EFFECT_FIRE_A:
-        fire(_effect, _y, _x);
-        threedee(_effect, _frame, 0, 210, _y, _x);
-        break;
-    case EFFECT_FIRE_C:
-    case EFFECT_FIRE_B:
-        if (_y % 4 == 0 && _x % 4 == 0)
-        {
-            plasma(_frame, _y, _x);
-        }
-        threedee(_effect, _frame, 1, 210, _y, _x);
-        break;
-    case EFFECT_WATER:
-        fire(_effect, _y, _x);
-        if (_y == 0 && _x == 0)
-        {
-            char const txt[] = "EGO SUM PICO";
-            if (_frame % 4 == 0 && _frame >= 120 && _frame <= 144)
-            {
-                uint8_t const txt_idx = (_frame - 120) / 4;
-                text_draw(50, 25 + txt_idx * 9, 2, &txt[txt_idx], 1, 250);
-            }
-            if (_frame == 160)
-            {
-                text_draw(50, 97, 2, &txt[8], 4, 250);
-            }
-        }
-        break;
-    case EFFECT_ACID:
-        fire(_effect, _y, _x);
-        break;
-    case EFFECT_FRACTAL:
-        if (_y % 2 == 0 && _x % 2 == 0)
-        {
-            /* The offset here is the sum of frame durations from start till
-             * this effect. */
-            fractal((_frame - 1136) + 110, _y, _x);
-            uint16_t const color = bg[_y][_x];
-            bg[_y][_x + 1] = color;
-            bg[_y + 1][_x] = color;
-            bg[_y + 1][_x + 1] = color;
-        }
-        break;
-    case EFFECT_3D_B:
-        chess(_frame, _y, _x);
-        if (_frame % 4 == 0)
-        {
-            threedee(_effect, _frame / 4, 1, 254, _y, _x);
-        }
-        break;
-    case EFFECT_END:
-        if (_y % 4 == 0 && _x % 4 == 0)
-        {
-            plasma(_frame, _y, _x);
-        }
-        if (_y == 0 && _x == 0)
+        uint8_t *const row = bench_scratch[_y];
+        uint8_t const x0 = (uint8_t)(_y * 37U);
+        uint8_t const shift = _y % 8U;
+        switch (kind)
         {
-            text_draw(36, 46, 1, "DECRUNCH  2023", 14, 128);
-            text_draw(44, 46, 1, "     WILD     ", 14, 128);
-            text_draw(52, 46, 1, "   RPI PICO   ", 14, 128);
-
-            text_draw(64, 46, 1, " CODE: 1935711", 14, 128);
-            text_draw(72, 46, 1, "MUSIC: EIGHTBM", 14, 128);
+        case 0:
+            span_xor(row, x0, (uint8_t)_y, (uint8_t)(_y * 3U));
+            break;
+        case 1:
+            span_checker(row, x0, (uint8_t)(_y * 5U), shift, (uint8_t)_y,
+                         (uint8_t)~_y);
+            break;
+        case 2:
+            span_stripes(row, x0, shift, (uint8_t)_y, (uint8_t)~_y);
+            break;
+        default:
+            span_gradient(row, (uint16_t)(_y * 613U),
+                          (int16_t)(_y * 97U - 6000U));
+            break;
         }
-        break;
     }
 }
 
-static void scanline(effect_et const _effect, uint8_t const _palette,
-                     uint32_t const _frame, uint16_t const _y)
+/* Pixel `_x` of row `_y` as filled by `bench_span_fill`, a pixel at a time. */
+static uint8_t bench_span_pixel(uint8_t const kind, uint16_t const _y,
+                                uint16_t const _x)
 {
-    for (int x = 0; x < VIDEO_W; ++x)
+    uint8_t const x = (uint8_t)(_y * 37U + _x);
+    uint8_t const shift = _y % 8U;
+    switch (kind)
     {
-        draw(_effect, _frame, (_y + 3) % VIDEO_H, x);
-        vid[_y][x] = palette_list[_palette][bg[_y][x]];
-        vid[_y][x] |= palette_list[_palette][fg[_y][x]];
+    case 0:
+        return (uint8_t)((x ^ _y) + _y * 3U);
+    case 1:
+        return ((x ^ (uint8_t)(_y * 5U)) >> shift) & 1U ? (uint8_t)~_y
+                                                         : (uint8_t)_y;
+    case 2:
+        return (x >> shift) & 1U ? (uint8_t)~_y : (uint8_t)_y;
+    default:
+        return (uint16_t)(_y * 613U + _x * (uint16_t)(_y * 97U - 6000U)) >>
+               8;
     }
 }
 
-/* "Worker thread" for each core. */
-// void __time_critical_func(render_loop)()
-static void render_loop()
+/* Every span generator against the same pattern made a pixel at a time. */
+static void bench_span()
 {
-    while (true)
+    static char const *const kind_name[] = {"xor", "checker", "stripes",
+                                            "gradient"};
+
+    for (uint8_t kind = 0; kind < 4; ++kind)
     {
-        if (y == VIDEO_H)
+        uint32_t start = time_us_32();
+        bench_span_fill(kind);
+        uint32_t const cycles_span = bench_cycles(start);
+
+        uint32_t mismatch = 0;
+        for (uint16_t _y = 0; _y < VIDEO_H; ++_y)
         {
-            frame_prologue_done = false;
-            frame_prologue(); // Start next frame.
+            for (uint16_t _x = 0; _x < VIDEO_W; ++_x)
+            {
+                mismatch +=
+                    bench_scratch[_y][_x] != bench_span_pixel(kind, _y, _x);
+            }
         }
-        uint16_t const _y = y++;
-        uint32_t const _frame = frame;
-        effect_et const _effect = effect;
 
-        scanline(_effect, palette, _frame, _y);
+        start = time_us_32();
+        for (uint16_t _y = 0; _y < VIDEO_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < VIDEO_W; ++_x)
+            {
+                bench_scratch[_y][_x] = bench_span_pixel(kind, _y, _x);
+            }
+        }
+        uint32_t const cycles_pixel = bench_cycles(start);
+
+        printf("span %s: %lu cycles/row, %lu a pixel at a time, %lu pixels "
+               "differ\n",
+               kind_name[kind], cycles_span / VIDEO_H, cycles_pixel / VIDEO_H,
+               mismatch);
     }
+    memset(bench_scratch, 0, sizeof(bench_scratch));
 }
 
-static void fill_scanline_buffer(struct scanvideo_scanline_buffer *const buffer)
+/* Returns the pixel at `_x`, `_y` as the compositor made it before the blend
+ * modes, a pixel at a time. */
+static uint16_t bench_blend_pixel(uint16_t const _y, uint16_t const _x)
 {
-    static uint32_t postamble[] = {0x0000U | (COMPOSABLE_EOL_ALIGN << 16)};
-
-    buffer->data[0] = 4;
-    buffer->data[1] = host_safe_hw_ptr(buffer->data + 8);
-    buffer->data[2] =
-        (VIDEO_W - 4) / 2; /* First four pixels are handled separately. */
-    volatile uint16_t *const pixels =
-        &vid[scanvideo_scanline_number(buffer->scanline_id)][0];
-    buffer->data[3] = host_safe_hw_ptr(pixels + 4);
-    buffer->data[4] = count_of(postamble);
-    buffer->data[5] = host_safe_hw_ptr(postamble);
-    buffer->data[6] = 0;
-    buffer->data[7] = 0;
-    buffer->data_used = 8;
-
-    // 3 pixel run followed by main run, consuming the first 4 pixels.
-    buffer->data[8] = (pixels[0] << 16U) | COMPOSABLE_RAW_RUN;
-    buffer->data[9] = (pixels[1] << 16U) | 0;
-    buffer->data[10] = (COMPOSABLE_RAW_RUN << 16U) | pixels[2];
-    buffer->data[11] =
-        (((VIDEO_W - 3) + 1 - 3) << 16U) |
-        pixels[3]; // Note we add one for the black pixel at the end.
+    return palette_bg[bg[_y][_x]] |
+           (uint16_t)(fg_pair[fg[_y][_x / 2]] >> ((_x & 1) * 16));
 }
 
-int64_t timer_callback(alarm_id_t const alarm_id, void *const user_data)
+/* Frames composed in every blend mode and, for comparison, with a pixel at a
+ * time as before, over a bg and fg filled with every index and level. */
+static void bench_blend()
 {
-    struct scanvideo_scanline_buffer *buffer =
-        scanvideo_begin_scanline_generation(false);
-    while (buffer)
+    uint32_t const frame_count = 20;
+    for (uint16_t _y = 0; _y < VIDEO_H; ++_y)
     {
-        fill_scanline_buffer(buffer);
-        scanvideo_end_scanline_generation(buffer);
-        buffer = scanvideo_begin_scanline_generation(false);
+        for (uint16_t _x = 0; _x < VIDEO_W; ++_x)
+        {
+            bg[_y][_x] = (uint8_t)(_y * 3U + _x);
+            fg_plot(fg[_y], _x, (uint8_t)(_y + _x * 5U) & FG_LEVEL_MAX);
+        }
     }
-    return 100;
-}
-
-static void audio_init()
-{
-    static audio_format_t audio_format = {
-        .format = AUDIO_BUFFER_FORMAT_PCM_S16,
-        .sample_freq = 8000,
-        .channel_count = 1,
-    };
-
-    static struct audio_buffer_format producer_format = {
-        .format = &audio_format,
-        .sample_stride = 2,
-    };
-
-    audio_buffer_pool =
-        audio_new_producer_pool(&producer_format, 3,
-                                SAMPLES_PER_BUFFER); // todo correct size
-
-    bool __unused ok;
-    const struct audio_format *output_format;
-    struct audio_i2s_config config = {
-        .data_pin = PICO_AUDIO_I2S_DATA_PIN,
-        .clock_pin_base = PICO_AUDIO_I2S_CLOCK_PIN_BASE,
-        .dma_channel = PICO_AUDIO_I2S_DMA_IRQ,
-        .pio_sm = PICO_AUDIO_I2S_PIO,
-    };
+    fg_ramp_create(EFFECT_3D_B);
 
-    output_format = audio_i2s_setup(&audio_format, &config);
-    if (!output_format)
+    uint64_t cycles_pixel = 0;
+    for (uint32_t _frame = 0; _frame < frame_count; ++_frame)
     {
-        panic("PicoAudio: Unable to open audio device.\n");
+        uint32_t const start = time_us_32();
+        for (uint16_t _y = 0; _y < VIDEO_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < VIDEO_W; ++_x)
+            {
+                vid[_y][_x] = bench_blend_pixel(_y, _x);
+            }
+        }
+        cycles_pixel += bench_cycles(start);
     }
+    printf("blend by pixel: %lu cycles/frame\n",
+           (uint32_t)(cycles_pixel / frame_count));
 
-    ok = audio_i2s_connect(audio_buffer_pool);
-    assert(ok);
-    audio_i2s_set_enabled(true);
-}
-
-static void core1_func()
-{
-    audio_init();
-    uint32_t step = 1;
-    uint32_t pos = 0;
-    uint32_t pos_max = __audio_bin_len - 1;
-
-    while (true)
+    static char const *const blend_name[4] = {"or", "add", "replace",
+                                              "average"};
+    blend_et const blend_prev = blend;
+    for (blend = BLEND_OR; blend <= BLEND_AVERAGE; ++blend)
     {
-        struct audio_buffer *buffer =
-            take_audio_buffer(audio_buffer_pool, true);
-        int16_t *samples = (int16_t *)buffer->buffer->bytes;
-        for (uint i = 0; i < buffer->max_sample_count; i++)
+        uint64_t cycles = 0;
+        for (uint32_t _frame = 0; _frame < frame_count; ++_frame)
         {
-            samples[i] = __audio_bin[pos] << 8;
-            // samples[i] = (vol * sine_wave_table[pos >> 16u]) >> 8u;
-            pos += step;
-            if (pos >= pos_max)
+            uint32_t const start = time_us_32();
+            for (uint16_t _y = 0; _y < VIDEO_H; ++_y)
             {
-                pos = pos_max;
+                switch (blend)
+                {
+                case BLEND_OR:
+                    blend_row(BLEND_OR, _y);
+                    break;
+                case BLEND_ADD:
+                    blend_row(BLEND_ADD, _y);
+                    break;
+                case BLEND_REPLACE:
+                    blend_row(BLEND_REPLACE, _y);
+                    break;
+                case BLEND_AVERAGE:
+                    blend_row(BLEND_AVERAGE, _y);
+                    break;
+                }
             }
+            cycles += bench_cycles(start);
         }
-        buffer->sample_count = buffer->max_sample_count;
-        give_audio_buffer(audio_buffer_pool, buffer);
+        printf("blend %s: %lu cycles/frame\n", blend_name[blend],
+               (uint32_t)(cycles / frame_count));
+
+        if (blend == BLEND_OR)
+        {
+            uint32_t mismatch = 0;
+            for (uint16_t _y = 0; _y < VIDEO_H; ++_y)
+            {
+                for (uint16_t _x = 0; _x < VIDEO_W; ++_x)
+                {
+                    mismatch += vid[_y][_x] != bench_blend_pixel(_y, _x);
+                }
+            }
+            printf("blend or vs by pixel: %lu pixels differ\n", mismatch);
+        }
+    }
+    blend = blend_prev;
+
+    memset(bg, 0, sizeof(bg));
+    memset(fg, 0, sizeof(fg));
+    fg_ramp_create(effect);
+}
+
+/* Decodes the start of the track as the audio core does, then rewinds it. */
+static void bench_audio()
+{
+    static uint32_t pairs[SAMPLES_PER_BUFFER / 2];
+    uint32_t const buffer_count = 64;
+    uint64_t cycles = 0;
+    for (uint32_t buffer_i = 0; buffer_i < buffer_count; ++buffer_i)
+    {
+        uint32_t const start = time_us_32();
+        audio_fill(pairs, SAMPLES_PER_BUFFER);
+        cycles += bench_cycles(start);
     }
+    audio_pos = 0;
+#if AUDIO_ADPCM
+    audio_adpcm_state = (adpcm_st){0, 0};
+#endif
+
+    printf("audio %s at %lu Hz: %lu cycles/sample\n",
+           AUDIO_ADPCM ? "ima-adpcm" : "pcm", (uint32_t)AUDIO_SAMPLE_RATE,
+           (uint32_t)(cycles / (buffer_count * SAMPLES_PER_BUFFER)));
 }
 
+/* Measures kernels against the ones they replace and prints the results
+ * before the demo starts. */
+static void bench()
+{
+    stdio_init_all();
+    bench_fire();
+    bench_fire_composed();
+    bench_fractal();
+    bench_plasma();
+    bench_threedee();
+    bench_text();
+    bench_sprite();
+    bench_span();
+    bench_blend();
+    bench_audio();
+#if FRACTAL_RENDER == FRACTAL_RENDER_SUBDIVIDE
+    bench_fractal_subdivide();
+#elif FRACTAL_RENDER == FRACTAL_RENDER_PROGRESSIVE
+    bench_fractal_progressive();
+#elif FRACTAL_RENDER == FRACTAL_RENDER_STREAM
+    bench_fractal_stream();
+#elif FRACTAL_RENDER == FRACTAL_RENDER_BUDGET
+    bench_fractal_budget();
+#endif
+}
+#endif
+
 static int vga_main(void)
 {
     palette_create();
-    vertex_gem_create();
+    fg_ramp_create(effect);
+    overlay_create();
+#if !PLASMA_FIXED_POINT || defined(BENCH)
+    plasma_create();
+#endif
+#ifdef BENCH
+    bench();
+#endif
 
     multicore_launch_core1(core1_func);
 
@@ -953,22 +3476,24 @@ static int vga_main(void)
 static void frame_prologue()
 {
 
-    /* Lookup table for durations of each effect. */
-    static uint32_t const effect_duration[EFFECT_END + 1] = {
-        10, 215, 131, 500, 280, 132, 360, 246, UINT32_MAX};
-    /* Lookup table for the palette that will be used by each effect. */
-    static uint8_t const effect_palette[EFFECT_END + 1] = {0, 1, 2, 1, 0,
-                                                           3, 4, 5, 3};
+    /* Lookup table for how each effect lays fg over bg. The gem of 3D_B
+     * covers the chess, whose colors would swallow it when ORed. */
+    static blend_et const effect_blend[EFFECT_END + 1] = {
+        BLEND_OR, BLEND_OR, BLEND_OR, BLEND_REPLACE, BLEND_OR,
+        BLEND_OR, BLEND_OR, BLEND_OR, BLEND_OR};
 
     if (!frame_prologue_done)
     {
+        palette_offset_prev = palette_offset;
         if (frame_rem == 0)
         {
             ++effect;
             frame_rem = effect_duration[effect];
             palette = effect_palette[effect];
+            blend = effect_blend[effect];
 
             // Prepare buffers for next effect.
+            overlay_invalidate();
             for (uint16_t _y = 0; _y < VIDEO_H; ++_y)
             {
                 for (uint16_t _x = 0; _x < VIDEO_W; ++_x)
@@ -976,24 +3501,43 @@ static void frame_prologue()
                     switch (effect)
                     {
                     case EFFECT_WATER:
-                        bg[_y][_x] /= 4;
+                        bg[_y][_x] =
+                            fire_decode(bg[_y][_x], palette_offset) / 4;
                         break;
                     case EFFECT_ACID:
-                        bg[_y][_x] /= 2;
+                        bg[_y][_x] =
+                            fire_decode(bg[_y][_x], palette_offset) / 2;
                         break;
                     default:
                         bg[_y][_x] = 0;
                         break;
                     }
-                    fg[_y][_x] = 0;
                 }
             }
+            memset(fg, 0, sizeof(fg));
+            fg_ramp_create(effect);
+            palette_offset = 0;
+            palette_offset_prev = 0;
+            row_dirty_add(0, VIDEO_H - 1);
         }
 
         ++frame;
         --frame_rem;
         y = 0;
 
+        if ((effect == EFFECT_WATER || effect == EFFECT_ACID) && frame % 2 == 0)
+        {
+            palette_offset = (palette_offset + 2) % 255;
+        }
+        palette_rotate();
+        if (palette_offset != palette_offset_prev)
+        {
+            row_dirty_add(0, VIDEO_H - 1);
+        }
+        /* Before any row is composed, so that captions show from their first
+         * frame on. */
+        overlay_update(frame);
+
         frame_prologue_done = true;
     }
 }
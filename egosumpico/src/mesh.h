@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Indexed meshes of the 3D effect, shared with the host tool that compiles
+ * them from model files. */
+
+/* Fraction bits of vertex positions and of face normals. */
+#define MESH_VERTEX_Q 7
+#define MESH_NORMAL_Q 14
+/* Most vertices a mesh may have. */
+#define MESH_VERTEX_MAX 32U
+
+/* Every vertex is transformed once per frame, then every edge is drawn once.
+ * Faces are listed counterclockwise as seen from outside, each with its unit
+ * normal. `center` and `radius` bound all vertices, in the same units. */
+typedef struct
+{
+    int16_t const (*vertex)[3];
+    uint8_t vertex_count;
+    uint8_t const (*edge)[2];
+    uint8_t edge_count;
+    uint8_t const (*face)[3];
+    int16_t const (*normal)[3];
+    uint8_t face_count;
+    int16_t center[3];
+    int16_t radius;
+} mesh_st;
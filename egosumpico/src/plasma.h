@@ -0,0 +1,18 @@
+#pragma once
+
+/* Fixed-point conventions of the plasma lookup tables, shared with the host
+ * tool that generates them. */
+
+/* Angles are 16 bits, a full turn wraps around to 0. */
+#define PLASMA_ANGLE_RAD_Q8 2670177U /* Angle units per radian, in Q8. */
+/* The sine table has 1 << PLASMA_SIN_BITS entries over a full turn, with
+ * PLASMA_SIN_Q fraction bits. */
+#define PLASMA_SIN_BITS 10U
+#define PLASMA_SIN_Q 14
+/* The shade table maps v * PI, as an angle, to the color of the plasma with
+ * 1 << PLASMA_SHADE_BITS entries over a full turn. */
+#define PLASMA_SHADE_BITS 10U
+/* The distance table has one entry per pixel of the screen, plus a row and a
+ * column past its bottom and right edge for interpolated samples. */
+#define PLASMA_DIST_W (160U + 1U)
+#define PLASMA_DIST_H (120U + 1U)
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Span generators fill a whole row of bg with a pattern, four pixels per
+ * 32-bit store. The pixels of a word are handled as four byte lanes, `x0` is
+ * the pattern coordinate of the first pixel of the row. Rows are word aligned
+ * and 160 pixels wide. */
+#define SPAN_WORDS (160U / 4U)
+#define SPAN_LANE_LOW 0x01010101UL
+#define SPAN_LANE_HIGH 0x80808080UL
+/* Offsets of the four pixels of a word, first pixel in the low byte. */
+#define SPAN_LANE_INDEX 0x03020100UL
+
+/* Adds `a` and `b` lane by lane, without carries between lanes. */
+static inline uint32_t span_lane_add(uint32_t const a, uint32_t const b)
+{
+    return ((a & ~SPAN_LANE_HIGH) + (b & ~SPAN_LANE_HIGH)) ^
+           ((a ^ b) & SPAN_LANE_HIGH);
+}
+
+/* Pixel x is ((x0 + x) ^ y) + bias, all modulo 256. */
+static inline void span_xor(uint8_t *const row, uint8_t const x0,
+                            uint8_t const y, uint8_t const bias)
+{
+    uint32_t *const row_word = (uint32_t *)row;
+    uint32_t const y_lanes = y * SPAN_LANE_LOW;
+    uint32_t const bias_lanes = bias * SPAN_LANE_LOW;
+    uint32_t x_lanes = span_lane_add(x0 * SPAN_LANE_LOW, SPAN_LANE_INDEX);
+
+    for (uint16_t word_i = 0; word_i < SPAN_WORDS; ++word_i)
+    {
+        row_word[word_i] = span_lane_add(x_lanes ^ y_lanes, bias_lanes);
+        x_lanes = span_lane_add(x_lanes, 4U * SPAN_LANE_LOW);
+    }
+}
+
+/* Squares of 1 << `shift` pixels, up to 128, alternating between colors `a`
+ * and `b` along the row and between rows as `y` changes. Pixel x is `b` where
+ * bit `shift` of (x0 + x) ^ y is set, modulo 256. */
+static inline void span_checker(uint8_t *const row, uint8_t const x0,
+                                uint8_t const y, uint8_t const shift,
+                                uint8_t const a, uint8_t const b)
+{
+    uint32_t *const row_word = (uint32_t *)row;
+    uint32_t const y_lanes = y * SPAN_LANE_LOW;
+    uint32_t const a_lanes = a * SPAN_LANE_LOW;
+    uint32_t const ab_lanes = (a ^ b) * SPAN_LANE_LOW;
+    uint32_t x_lanes = span_lane_add(x0 * SPAN_LANE_LOW, SPAN_LANE_INDEX);
+
+    for (uint16_t word_i = 0; word_i < SPAN_WORDS; ++word_i)
+    {
+        /* 0xFF in the lanes of color b. */
+        uint32_t const b_mask =
+            (((x_lanes ^ y_lanes) >> shift) & SPAN_LANE_LOW) * 0xFFU;
+        row_word[word_i] = a_lanes ^ (ab_lanes & b_mask);
+        x_lanes = span_lane_add(x_lanes, 4U * SPAN_LANE_LOW);
+    }
+}
+
+/* Vertical stripes, the checker of a single row. */
+static inline void span_stripes(uint8_t *const row, uint8_t const x0,
+                                uint8_t const shift, uint8_t const a,
+                                uint8_t const b)
+{
+    span_checker(row, x0, 0, shift, a, b);
+}
+
+/* Pixel x is (start + x * step) >> 8, from Q8 `start` and `step`, modulo
+ * 65536. */
+static inline void span_gradient(uint8_t *const row, uint16_t const start,
+                                 int16_t const step)
+{
+    uint32_t *const row_word = (uint32_t *)row;
+    uint16_t val = start;
+
+    for (uint16_t word_i = 0; word_i < SPAN_WORDS; ++word_i)
+    {
+        uint32_t word = 0;
+        for (uint8_t lane = 0; lane < 4; ++lane)
+        {
+            word |= (uint32_t)(val >> 8) << (lane * 8U);
+            val += step;
+        }
+        row_word[word_i] = word;
+    }
+}
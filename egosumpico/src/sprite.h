@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Run-length coded 8-bit sprites, shared with the host tool that converts
+ * them from images.
+ *
+ * Every row of `data` starts with its number of runs, then each run is:
+ *   ssssssss cccccccc p0 ... pc-1
+ * s transparent pixels are skipped, then c opaque pixels follow. Rows are at
+ * most 255 pixels wide and `row[y]` is the offset of row `y` in `data`, so
+ * rows above the screen are never read. Pixel value 0 of the image is
+ * transparent. */
+typedef struct
+{
+    uint8_t w;
+    uint8_t h;
+    uint16_t const *row;
+    uint8_t const *data;
+} sprite_st;
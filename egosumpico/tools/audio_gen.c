@@ -0,0 +1,294 @@
+/* Converts the soundtrack into a C header, as 8-bit PCM or 4-bit IMA-ADPCM.
+ *
+ * Usage: audio_gen <output.h> <track.bin|track.wav> <pcm|adpcm>
+ *
+ * A `.wav` track is 8 or 16-bit PCM, mono or stereo which is mixed down, at
+ * any rate. Any other track is raw signed 8-bit mono PCM at 8 kHz.
+ *
+ * With `pcm`, word `i` of `audio_pcm` holds the high bytes of samples `4 * i`
+ * to `4 * i + 3`, the first in the low byte. The last word is padded with the
+ * last sample, and one more word holding it 4 times follows, so a player that
+ * stops on the last word holds the last sample.
+ *
+ * With `adpcm`, `audio_adpcm` holds the codes of `adpcm.h`, padded to a whole
+ * byte with the last sample. Codes are chosen looking one sample ahead. The
+ * track is decoded back as the demo does and its signal to noise ratio
+ * printed. */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "adpcm.h"
+
+#define RAW_SAMPLE_RATE 8000U
+
+static char const *track_path;
+static int16_t *track;
+static size_t track_len;
+static size_t track_cap;
+static uint32_t track_rate = RAW_SAMPLE_RATE;
+
+static void track_fail(char const *const message)
+{
+    fprintf(stderr, "audio_gen: %s: %s\n", track_path, message);
+    exit(EXIT_FAILURE);
+}
+
+static void track_put(int16_t const sample)
+{
+    if (track_len == track_cap)
+    {
+        track_cap = track_cap ? track_cap * 2U : 65536U;
+        track = realloc(track, track_cap * sizeof(*track));
+        if (!track)
+        {
+            track_fail("out of memory");
+        }
+    }
+    track[track_len++] = sample;
+}
+
+static uint32_t read_le(uint8_t const *const bytes, uint8_t const len)
+{
+    uint32_t value = 0;
+    for (uint8_t byte_i = 0; byte_i < len; ++byte_i)
+    {
+        value |= (uint32_t)bytes[byte_i] << (byte_i * 8U);
+    }
+    return value;
+}
+
+static void track_read_raw(FILE *const in)
+{
+    int byte;
+    while ((byte = fgetc(in)) != EOF)
+    {
+        track_put((int16_t)((int8_t)byte * 256));
+    }
+}
+
+static void track_read_wav(FILE *const in)
+{
+    uint8_t header[12];
+    if (fread(header, 1, 12, in) != 12 || memcmp(header, "RIFF", 4) ||
+        memcmp(&header[8], "WAVE", 4))
+    {
+        track_fail("not a WAV file");
+    }
+
+    uint16_t channels = 0;
+    uint16_t bits = 0;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, 8, in) == 8)
+    {
+        uint32_t const chunk_len = read_le(&chunk[4], 4);
+        if (!memcmp(chunk, "fmt ", 4))
+        {
+            uint8_t format[16];
+            if (chunk_len < 16 || fread(format, 1, 16, in) != 16)
+            {
+                track_fail("bad format chunk");
+            }
+            channels = (uint16_t)read_le(&format[2], 2);
+            track_rate = read_le(&format[4], 4);
+            bits = (uint16_t)read_le(&format[14], 2);
+            if (read_le(format, 2) != 1 || channels < 1 || channels > 2 ||
+                (bits != 8 && bits != 16))
+            {
+                track_fail("only 8 or 16-bit PCM in 1 or 2 channels");
+            }
+            fseek(in, (long)(chunk_len - 16U + (chunk_len & 1U)), SEEK_CUR);
+        }
+        else if (!memcmp(chunk, "data", 4))
+        {
+            if (!channels)
+            {
+                track_fail("data before format");
+            }
+            uint8_t const frame_len = (uint8_t)(channels * bits / 8U);
+            uint8_t frame[4];
+            for (uint32_t frame_i = 0; frame_i < chunk_len / frame_len;
+                 ++frame_i)
+            {
+                if (fread(frame, 1, frame_len, in) != frame_len)
+                {
+                    track_fail("file ends early");
+                }
+                int32_t sum = 0;
+                for (uint16_t channel = 0; channel < channels; ++channel)
+                {
+                    sum += bits == 8
+                               ? ((int32_t)frame[channel] - 128) * 256
+                               : (int16_t)read_le(&frame[channel * 2U], 2);
+                }
+                track_put((int16_t)(sum / channels));
+            }
+            return;
+        }
+        else
+        {
+            fseek(in, (long)(chunk_len + (chunk_len & 1U)), SEEK_CUR);
+        }
+    }
+    track_fail("no data chunk");
+}
+
+static void write_pcm(FILE *const out)
+{
+    /* Padding and the hold word. */
+    size_t const word_count = (track_len + 3U) / 4U + 1U;
+    fprintf(out, "uint32_t const __in_flash(\"audio\") audio_pcm[%zu] = {",
+            word_count);
+    for (size_t word_i = 0; word_i < word_count; ++word_i)
+    {
+        uint32_t word = 0;
+        for (size_t sample_i = word_i * 4U; sample_i < word_i * 4U + 4U;
+             ++sample_i)
+        {
+            int16_t const sample =
+                track[sample_i < track_len ? sample_i : track_len - 1U];
+            word |= (uint32_t)((uint16_t)sample >> 8) << (sample_i % 4U * 8U);
+        }
+        fprintf(out, "%s0x%08x,", word_i % 6 ? " " : "\n  ", word);
+    }
+    fprintf(out, "\n};\n");
+
+    printf("audio_gen: %zu samples at %u Hz as 8-bit PCM in %zu bytes\n",
+           track_len, track_rate, word_count * 4U);
+}
+
+/* Squared error of `code` at `sample` from `state`, plus the least one it
+ * leaves for `next`. */
+static int64_t adpcm_error(adpcm_st state, uint8_t const code,
+                           int16_t const sample, int16_t const next)
+{
+    int64_t const error = adpcm_decode(&state, code) - sample;
+    int64_t next_best = INT64_MAX;
+    for (uint8_t next_code = 0; next_code < 16U; ++next_code)
+    {
+        adpcm_st trial = state;
+        int64_t const next_error = adpcm_decode(&trial, next_code) - next;
+        next_best = next_error * next_error < next_best
+                        ? next_error * next_error
+                        : next_best;
+    }
+    return error * error + next_best;
+}
+
+/* Code for `sample` that, looking one sample ahead to `next`, brings `state`
+ * closest to the track. */
+static uint8_t adpcm_encode(adpcm_st *const state, int16_t const sample,
+                            int16_t const next)
+{
+    uint8_t code_best = 0;
+    int64_t error_best = INT64_MAX;
+    for (uint8_t code = 0; code < 16U; ++code)
+    {
+        int64_t const error = adpcm_error(*state, code, sample, next);
+        if (error < error_best)
+        {
+            code_best = code;
+            error_best = error;
+        }
+    }
+    adpcm_decode(state, code_best);
+    return code_best;
+}
+
+static void write_adpcm(FILE *const out)
+{
+    size_t const byte_count = (track_len + 1U) / 2U;
+    adpcm_st state = {0, 0};
+    double signal = 0.0;
+    double noise = 0.0;
+
+    fprintf(out, "uint8_t const __in_flash(\"audio\") audio_adpcm[%zu] = {",
+            byte_count);
+    for (size_t byte_i = 0; byte_i < byte_count; ++byte_i)
+    {
+        uint8_t byte = 0;
+        for (size_t sample_i = byte_i * 2U; sample_i < byte_i * 2U + 2U;
+             ++sample_i)
+        {
+            int16_t const sample =
+                track[sample_i < track_len ? sample_i : track_len - 1U];
+            int16_t const next =
+                track[sample_i + 1U < track_len ? sample_i + 1U
+                                                : track_len - 1U];
+            byte |= adpcm_encode(&state, sample, next) << (sample_i % 2U * 4U);
+            if (sample_i < track_len)
+            {
+                double const error = (double)state.sample - sample;
+                signal += (double)sample * sample;
+                noise += error * error;
+            }
+        }
+        fprintf(out, "%s0x%02x,", byte_i % 12 ? " " : "\n  ", byte);
+    }
+    fprintf(out, "\n};\n");
+
+    printf("audio_gen: %zu samples at %u Hz as IMA-ADPCM in %zu bytes, "
+           "SNR %.1f dB\n",
+           track_len, track_rate, byte_count,
+           noise > 0.0 ? 10.0 * log10(signal / noise) : INFINITY);
+}
+
+int main(int const argc, char const *const argv[])
+{
+    bool const adpcm = argc == 4 && !strcmp(argv[3], "adpcm");
+    if (argc != 4 || (!adpcm && strcmp(argv[3], "pcm")))
+    {
+        fprintf(stderr,
+                "usage: audio_gen <output.h> <track.bin|track.wav> "
+                "<pcm|adpcm>\n");
+        return EXIT_FAILURE;
+    }
+
+    track_path = argv[2];
+    FILE *const in = fopen(track_path, "rb");
+    if (!in)
+    {
+        perror(track_path);
+        return EXIT_FAILURE;
+    }
+    char const *const ext = strrchr(track_path, '.');
+    if (ext && (!strcmp(ext, ".wav") || !strcmp(ext, ".WAV")))
+    {
+        track_read_wav(in);
+    }
+    else
+    {
+        track_read_raw(in);
+    }
+    fclose(in);
+    if (track_len == 0)
+    {
+        track_fail("no samples");
+    }
+
+    FILE *const out = fopen(argv[1], "w");
+    if (!out)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    fprintf(out, "/* Generated by audio_gen, do not edit. */\n");
+    fprintf(out, "#define AUDIO_ADPCM %d\n", adpcm);
+    fprintf(out, "#define AUDIO_SAMPLE_RATE %uU\n", track_rate);
+    fprintf(out, "#define AUDIO_SAMPLE_COUNT %zuU\n", track_len);
+    if (adpcm)
+    {
+        write_adpcm(out);
+    }
+    else
+    {
+        write_pcm(out);
+    }
+    fclose(out);
+    free(track);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+/* Rasterises the 3x5 font at every scale up to FONT_SCALE_MAX and writes the
+ * glyph atlas into a C header.
+ *
+ * Usage: font_gen <output.h>
+ *
+ * font_atlas[scale - 1][glyph][row] holds one pixel row of a scaled glyph,
+ * bit `i` is the pixel `i` to the right of the glyph's left edge. Rows below
+ * `FONT_H * scale` are 0. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "font.h"
+
+_Static_assert(FONT_W * FONT_SCALE_MAX <= 8U, "glyph rows must fit in a byte");
+
+int main(int const argc, char const *const argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: font_gen <output.h>\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE *const out = fopen(argv[1], "w");
+    if (!out)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    fprintf(out, "/* Generated by font_gen, do not edit. */\n");
+    fprintf(out, "uint8_t const __in_flash(\"font_atlas\") "
+                 "font_atlas[%u][%u][%u] = {",
+            FONT_SCALE_MAX, FONT_GLYPH_COUNT, FONT_H * FONT_SCALE_MAX);
+    for (uint32_t scale = 1; scale <= FONT_SCALE_MAX; ++scale)
+    {
+        fprintf(out, "\n  {");
+        for (uint32_t glyph_i = 0; glyph_i < FONT_GLYPH_COUNT; ++glyph_i)
+        {
+            fprintf(out, "\n    {");
+            for (uint32_t row = 0; row < FONT_H * FONT_SCALE_MAX; ++row)
+            {
+                uint8_t bits = 0;
+                for (uint32_t col = 0; col < FONT_W * scale; ++col)
+                {
+                    uint32_t const seg = (row / scale) * FONT_W + col / scale;
+                    if (row < FONT_H * scale)
+                    {
+                        bits |= ((font_glyph[glyph_i] >> seg) & 1U) << col;
+                    }
+                }
+                fprintf(out, "%s0x%02x,", row ? " " : "", bits);
+            }
+            fprintf(out, "},");
+        }
+        fprintf(out, "\n  },");
+    }
+    fprintf(out, "\n};\n");
+    fclose(out);
+
+    printf("font_gen: %u glyphs at %u scales\n", FONT_GLYPH_COUNT,
+           FONT_SCALE_MAX);
+    return EXIT_SUCCESS;
+}
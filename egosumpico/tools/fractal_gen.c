@@ -0,0 +1,128 @@
+/* Renders every frame of the fractal effect with the fixed-point kernel the
+ * demo uses and writes them as a compressed stream into a C header.
+ *
+ * Usage: fractal_gen <output.h>
+ *
+ * Each frame is coded against the previous one (the first against a cleared
+ * buffer), one sample row at a time and runs never cross a row:
+ *   1nnnnnnn          n + 1 samples are unchanged.
+ *   01nnnnnn llllllll n + 1 samples of level l.
+ *   00llllll          one sample of level l.
+ * A level is the color of the sample divided by 2. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fractal.h"
+
+#define RUN_SKIP_MAX 128U
+#define RUN_FILL_MAX 64U
+
+static uint8_t level_prev[FRACTAL_H][FRACTAL_W];
+static uint8_t level[FRACTAL_H][FRACTAL_W];
+
+static uint8_t *stream;
+static size_t stream_len;
+static size_t stream_cap;
+
+static void stream_put(uint8_t const byte)
+{
+    if (stream_len == stream_cap)
+    {
+        stream_cap = stream_cap ? stream_cap * 2 : 4096;
+        stream = realloc(stream, stream_cap);
+        if (!stream)
+        {
+            fprintf(stderr, "fractal_gen: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    stream[stream_len++] = byte;
+}
+
+static void row_encode(uint8_t const *const row, uint8_t const *const row_prev)
+{
+    uint16_t x = 0;
+    while (x < FRACTAL_W)
+    {
+        uint16_t run = 1;
+        if (row[x] == row_prev[x])
+        {
+            while (x + run < FRACTAL_W && run < RUN_SKIP_MAX &&
+                   row[x + run] == row_prev[x + run])
+            {
+                ++run;
+            }
+            stream_put(0x80 | (run - 1));
+        }
+        else
+        {
+            while (x + run < FRACTAL_W && run < RUN_FILL_MAX &&
+                   row[x + run] == row[x])
+            {
+                ++run;
+            }
+            if (run == 1)
+            {
+                stream_put(row[x]);
+            }
+            else
+            {
+                stream_put(0x40 | (run - 1));
+                stream_put(row[x]);
+            }
+        }
+        x += run;
+    }
+}
+
+int main(int const argc, char const *const argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: fractal_gen <output.h>\n");
+        return EXIT_FAILURE;
+    }
+
+    for (uint32_t frame_i = 0; frame_i < FRACTAL_FRAME_COUNT; ++frame_i)
+    {
+        int32_t const imaginary_c = fractal_to_fixed(
+            fractal_imaginary_c(FRACTAL_FRAME_REL_FIRST + frame_i));
+        for (uint16_t _y = 0; _y < FRACTAL_H; ++_y)
+        {
+            for (uint16_t _x = 0; _x < FRACTAL_W; ++_x)
+            {
+                level[_y][_x] =
+                    FRACTAL_ITERATION_MAX -
+                    fractal_iterate_fixed(imaginary_c, _y, _x,
+                                          FRACTAL_ITERATION_MAX);
+            }
+            row_encode(level[_y], level_prev[_y]);
+        }
+        memcpy(level_prev, level, sizeof(level));
+    }
+
+    FILE *const out = fopen(argv[1], "w");
+    if (!out)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    fprintf(out, "/* Generated by fractal_gen, do not edit. */\n");
+    fprintf(out, "#define FRACTAL_STREAM_FRAMES %uU\n", FRACTAL_FRAME_COUNT);
+    fprintf(out, "uint8_t const __in_flash(\"fractal_stream\") "
+                 "fractal_stream[] = {");
+    for (size_t byte_i = 0; byte_i < stream_len; ++byte_i)
+    {
+        fprintf(out, "%s0x%02x,", byte_i % 12 ? " " : "\n  ", stream[byte_i]);
+    }
+    fprintf(out, "\n};\n");
+    fclose(out);
+
+    printf("fractal_gen: %u frames in %zu bytes (%zu raw)\n",
+           FRACTAL_FRAME_COUNT, stream_len,
+           (size_t)FRACTAL_FRAME_COUNT * FRACTAL_W * FRACTAL_H);
+    return EXIT_SUCCESS;
+}
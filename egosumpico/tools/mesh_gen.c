@@ -0,0 +1,560 @@
+/* Compiles model files into the indexed meshes of the 3D effect and writes
+ * them into a C header.
+ *
+ * Usage: mesh_gen <output.h> <model.obj|model.ply>...
+ *
+ * Each model becomes a `mesh_st` named after its file, `data/gem.obj` gives
+ * `mesh_gem`. Models are read from Wavefront OBJ (`v` and `f` lines) or ASCII
+ * PLY (the `vertex` and `face` elements), polygons are split into fans of
+ * triangles. Positions are rounded to Q7, vertices that end up at the same
+ * position are merged and vertices no face uses are dropped, then each edge
+ * shared by faces is listed once. Face normals and the bounding sphere are
+ * computed from the rounded positions. */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mesh.h"
+
+#define MODEL_VERTEX_MAX 1024U
+#define MODEL_FACE_MAX 255U
+#define MODEL_POLYGON_MAX 16U
+#define LINE_MAX_LEN 512U
+
+typedef struct
+{
+    /* Vertices as read, then rounded and merged. */
+    double position[MODEL_VERTEX_MAX][3];
+    uint32_t position_count;
+    int16_t vertex[MODEL_VERTEX_MAX][3];
+    uint32_t vertex_count;
+    /* Faces as indices into `position`, then into `vertex`. */
+    uint32_t face[MODEL_FACE_MAX][3];
+    uint32_t face_count;
+    uint8_t edge[MODEL_FACE_MAX * 3U][2];
+    uint32_t edge_count;
+    int16_t normal[MODEL_FACE_MAX][3];
+    int16_t center[3];
+    int16_t radius;
+} model_st;
+
+static model_st model;
+static char const *model_path;
+
+static void model_fail(char const *const message)
+{
+    fprintf(stderr, "mesh_gen: %s: %s\n", model_path, message);
+    exit(EXIT_FAILURE);
+}
+
+static void model_position_add(double const x, double const y, double const z)
+{
+    if (model.position_count == MODEL_VERTEX_MAX)
+    {
+        model_fail("too many vertices");
+    }
+    model.position[model.position_count][0] = x;
+    model.position[model.position_count][1] = y;
+    model.position[model.position_count][2] = z;
+    ++model.position_count;
+}
+
+/* Adds a polygon of `count` vertices as a fan of triangles. */
+static void model_polygon_add(uint32_t const *const index, uint32_t const count)
+{
+    if (count < 3)
+    {
+        model_fail("face with less than 3 vertices");
+    }
+    for (uint32_t index_i = 0; index_i < count; ++index_i)
+    {
+        if (index[index_i] >= model.position_count)
+        {
+            model_fail("face uses a vertex that does not exist");
+        }
+    }
+    for (uint32_t fan_i = 1; fan_i + 1 < count; ++fan_i)
+    {
+        if (model.face_count == MODEL_FACE_MAX)
+        {
+            model_fail("too many faces");
+        }
+        model.face[model.face_count][0] = index[0];
+        model.face[model.face_count][1] = index[fan_i];
+        model.face[model.face_count][2] = index[fan_i + 1];
+        ++model.face_count;
+    }
+}
+
+static void model_obj_read(FILE *const in)
+{
+    char line[LINE_MAX_LEN];
+    while (fgets(line, sizeof(line), in))
+    {
+        if (line[0] == 'v' && isspace((unsigned char)line[1]))
+        {
+            double x, y, z;
+            if (sscanf(line + 1, "%lf %lf %lf", &x, &y, &z) != 3)
+            {
+                model_fail("bad vertex");
+            }
+            model_position_add(x, y, z);
+        }
+        else if (line[0] == 'f' && isspace((unsigned char)line[1]))
+        {
+            uint32_t index[MODEL_POLYGON_MAX];
+            uint32_t count = 0;
+            for (char *token = strtok(line + 1, " \t\r\n"); token;
+                 token = strtok(NULL, " \t\r\n"))
+            {
+                if (count == MODEL_POLYGON_MAX)
+                {
+                    model_fail("face with too many vertices");
+                }
+                /* Texture and normal indices after a '/' are ignored,
+                 * negative indices count back from the last vertex. */
+                long const obj_index = strtol(token, NULL, 10);
+                if (obj_index == 0)
+                {
+                    model_fail("bad face");
+                }
+                index[count++] =
+                    obj_index > 0
+                        ? (uint32_t)(obj_index - 1)
+                        : (uint32_t)((long)model.position_count + obj_index);
+            }
+            model_polygon_add(index, count);
+        }
+    }
+}
+
+static void model_ply_read(FILE *const in)
+{
+    /* Elements in the order of the header, the x, y and z properties of
+     * `vertex` must be scalars, the vertex list of `face` must come first. */
+    enum
+    {
+        ELEMENT_MAX = 8
+    };
+    char name[ELEMENT_MAX][64];
+    uint32_t count[ELEMENT_MAX];
+    uint32_t element_count = 0;
+    int32_t axis_property[3] = {-1, -1, -1};
+    uint32_t property_count = 0;
+
+    char line[LINE_MAX_LEN];
+    if (!fgets(line, sizeof(line), in) || strncmp(line, "ply", 3) != 0)
+    {
+        model_fail("not a PLY file");
+    }
+    while (fgets(line, sizeof(line), in))
+    {
+        char word[3][64];
+        int const word_count =
+            sscanf(line, "%63s %63s %63s", word[0], word[1], word[2]);
+        if (word_count < 1)
+        {
+            continue;
+        }
+        if (strcmp(word[0], "end_header") == 0)
+        {
+            break;
+        }
+        if (strcmp(word[0], "format") == 0 &&
+            (word_count < 2 || strcmp(word[1], "ascii") != 0))
+        {
+            model_fail("only ASCII PLY is supported");
+        }
+        else if (strcmp(word[0], "element") == 0 && word_count == 3)
+        {
+            if (element_count == ELEMENT_MAX)
+            {
+                model_fail("too many elements");
+            }
+            strcpy(name[element_count], word[1]);
+            count[element_count] = (uint32_t)strtoul(word[2], NULL, 10);
+            ++element_count;
+            property_count = 0;
+        }
+        else if (strcmp(word[0], "property") == 0 && element_count > 0 &&
+                 strcmp(name[element_count - 1], "vertex") == 0)
+        {
+            char const *const property = strrchr(line, ' ') + 1;
+            for (uint8_t axis = 0; axis < 3; ++axis)
+            {
+                if (property[0] == "xyz"[axis] && isspace(property[1]))
+                {
+                    axis_property[axis] = (int32_t)property_count;
+                }
+            }
+            ++property_count;
+        }
+    }
+    if (axis_property[0] < 0 || axis_property[1] < 0 || axis_property[2] < 0)
+    {
+        model_fail("vertices without x, y and z");
+    }
+
+    for (uint32_t element_i = 0; element_i < element_count; ++element_i)
+    {
+        for (uint32_t item_i = 0; item_i < count[element_i]; ++item_i)
+        {
+            if (!fgets(line, sizeof(line), in))
+            {
+                model_fail("file ends early");
+            }
+            if (strcmp(name[element_i], "vertex") == 0)
+            {
+                double value[3] = {0.0, 0.0, 0.0};
+                uint8_t axis_found = 0;
+                char *cursor = line;
+                for (int32_t property_i = 0;; ++property_i)
+                {
+                    char *end;
+                    double const property = strtod(cursor, &end);
+                    if (end == cursor)
+                    {
+                        break;
+                    }
+                    for (uint8_t axis = 0; axis < 3; ++axis)
+                    {
+                        if (property_i == axis_property[axis])
+                        {
+                            value[axis] = property;
+                            axis_found |= 1U << axis;
+                        }
+                    }
+                    cursor = end;
+                }
+                if (axis_found != 7U)
+                {
+                    model_fail("vertex without x, y and z");
+                }
+                model_position_add(value[0], value[1], value[2]);
+            }
+            else if (strcmp(name[element_i], "face") == 0)
+            {
+                uint32_t index[MODEL_POLYGON_MAX];
+                char *cursor = line;
+                uint32_t const index_count = strtoul(cursor, &cursor, 10);
+                if (index_count > MODEL_POLYGON_MAX)
+                {
+                    model_fail("face with too many vertices");
+                }
+                for (uint32_t index_i = 0; index_i < index_count; ++index_i)
+                {
+                    index[index_i] = strtoul(cursor, &cursor, 10);
+                }
+                model_polygon_add(index, index_count);
+            }
+        }
+    }
+}
+
+/* Rounds the positions, merges equal vertices and drops unused ones. Faces
+ * that collapse to a line are dropped, and so are repeated faces. */
+static void model_index()
+{
+    static int16_t rounded[MODEL_VERTEX_MAX][3];
+    static uint32_t merged[MODEL_VERTEX_MAX];
+    static uint32_t remap[MODEL_VERTEX_MAX];
+
+    for (uint32_t position_i = 0; position_i < model.position_count;
+         ++position_i)
+    {
+        for (uint8_t axis = 0; axis < 3; ++axis)
+        {
+            long const q = lround(model.position[position_i][axis] *
+                                  (1L << MESH_VERTEX_Q));
+            if (q < INT16_MIN || q > INT16_MAX)
+            {
+                model_fail("vertex out of range");
+            }
+            rounded[position_i][axis] = (int16_t)q;
+        }
+        merged[position_i] = position_i;
+        for (uint32_t other_i = 0; other_i < position_i; ++other_i)
+        {
+            if (memcmp(rounded[other_i], rounded[position_i],
+                       sizeof(rounded[0])) == 0)
+            {
+                merged[position_i] = other_i;
+                break;
+            }
+        }
+    }
+
+    uint32_t face_count = 0;
+    for (uint32_t face_i = 0; face_i < model.face_count; ++face_i)
+    {
+        uint32_t face[3];
+        for (uint8_t corner = 0; corner < 3; ++corner)
+        {
+            face[corner] = merged[model.face[face_i][corner]];
+        }
+        if (face[0] == face[1] || face[1] == face[2] || face[2] == face[0])
+        {
+            continue;
+        }
+        bool repeated = false;
+        for (uint32_t other_i = 0; other_i < face_count && !repeated;
+             ++other_i)
+        {
+            for (uint8_t turn = 0; turn < 3; ++turn)
+            {
+                uint32_t const *const other = model.face[other_i];
+                repeated |= other[turn] == face[0] &&
+                            other[(turn + 1) % 3] == face[1] &&
+                            other[(turn + 2) % 3] == face[2];
+            }
+        }
+        if (!repeated)
+        {
+            memcpy(model.face[face_count++], face, sizeof(face));
+        }
+    }
+    model.face_count = face_count;
+
+    for (uint32_t position_i = 0; position_i < model.position_count;
+         ++position_i)
+    {
+        remap[position_i] = UINT32_MAX;
+    }
+    for (uint32_t position_i = 0; position_i < model.position_count;
+         ++position_i)
+    {
+        bool used = false;
+        for (uint32_t face_i = 0; face_i < model.face_count; ++face_i)
+        {
+            for (uint8_t corner = 0; corner < 3; ++corner)
+            {
+                used |= model.face[face_i][corner] == position_i;
+            }
+        }
+        if (used)
+        {
+            if (model.vertex_count == MESH_VERTEX_MAX)
+            {
+                model_fail("more vertices than MESH_VERTEX_MAX");
+            }
+            memcpy(model.vertex[model.vertex_count], rounded[position_i],
+                   sizeof(rounded[0]));
+            remap[position_i] = model.vertex_count++;
+        }
+    }
+    for (uint32_t face_i = 0; face_i < model.face_count; ++face_i)
+    {
+        for (uint8_t corner = 0; corner < 3; ++corner)
+        {
+            model.face[face_i][corner] = remap[model.face[face_i][corner]];
+        }
+    }
+}
+
+/* Lists every edge of the faces once, in the direction it is first met. */
+static void model_edge_create()
+{
+    for (uint32_t face_i = 0; face_i < model.face_count; ++face_i)
+    {
+        for (uint8_t corner = 0; corner < 3; ++corner)
+        {
+            uint8_t const a = (uint8_t)model.face[face_i][corner];
+            uint8_t const b = (uint8_t)model.face[face_i][(corner + 1) % 3];
+            bool known = false;
+            for (uint32_t edge_i = 0; edge_i < model.edge_count; ++edge_i)
+            {
+                uint8_t const *const edge = model.edge[edge_i];
+                known |= (edge[0] == a && edge[1] == b) ||
+                         (edge[0] == b && edge[1] == a);
+            }
+            if (!known)
+            {
+                model.edge[model.edge_count][0] = a;
+                model.edge[model.edge_count][1] = b;
+                ++model.edge_count;
+            }
+        }
+    }
+}
+
+static void model_normal_create()
+{
+    for (uint32_t face_i = 0; face_i < model.face_count; ++face_i)
+    {
+        int16_t const *const a = model.vertex[model.face[face_i][0]];
+        int16_t const *const b = model.vertex[model.face[face_i][1]];
+        int16_t const *const c = model.vertex[model.face[face_i][2]];
+        double const ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        double const ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        double const normal[3] = {ab[1] * ac[2] - ab[2] * ac[1],
+                                  ab[2] * ac[0] - ab[0] * ac[2],
+                                  ab[0] * ac[1] - ab[1] * ac[0]};
+        double const len = sqrt(normal[0] * normal[0] +
+                                normal[1] * normal[1] + normal[2] * normal[2]);
+        for (uint8_t axis = 0; axis < 3; ++axis)
+        {
+            model.normal[face_i][axis] = (int16_t)lround(
+                normal[axis] / len * (1L << MESH_NORMAL_Q));
+        }
+    }
+}
+
+/* Sphere around the center of the bounding box, the radius rounded up. */
+static void model_sphere_create()
+{
+    for (uint8_t axis = 0; axis < 3; ++axis)
+    {
+        int16_t low = INT16_MAX;
+        int16_t high = INT16_MIN;
+        for (uint32_t vertex_i = 0; vertex_i < model.vertex_count; ++vertex_i)
+        {
+            int16_t const v = model.vertex[vertex_i][axis];
+            low = v < low ? v : low;
+            high = v > high ? v : high;
+        }
+        model.center[axis] = (int16_t)((low + high) / 2);
+    }
+    double radius_sq = 0.0;
+    for (uint32_t vertex_i = 0; vertex_i < model.vertex_count; ++vertex_i)
+    {
+        double dist_sq = 0.0;
+        for (uint8_t axis = 0; axis < 3; ++axis)
+        {
+            double const d = model.vertex[vertex_i][axis] - model.center[axis];
+            dist_sq += d * d;
+        }
+        radius_sq = dist_sq > radius_sq ? dist_sq : radius_sq;
+    }
+    model.radius = (int16_t)ceil(sqrt(radius_sq));
+}
+
+/* `mesh_` followed by the file name without directory and extension. */
+static void model_name(char *const name, size_t const name_len)
+{
+    char const *base = strrchr(model_path, '/');
+    base = base ? base + 1 : model_path;
+    size_t len = snprintf(name, name_len, "mesh_%s", base);
+    char *const dot = strrchr(name, '.');
+    if (dot)
+    {
+        *dot = '\0';
+        len = (size_t)(dot - name);
+    }
+    for (size_t char_i = 0; char_i < len; ++char_i)
+    {
+        if (!isalnum((unsigned char)name[char_i]))
+        {
+            name[char_i] = '_';
+        }
+    }
+}
+
+static void model_write(FILE *const out)
+{
+    char name[128];
+    model_name(name, sizeof(name));
+
+    fprintf(out, "int16_t const __in_flash(\"%s\") %s_vertex[%u][3] = {",
+            name, name, model.vertex_count);
+    for (uint32_t vertex_i = 0; vertex_i < model.vertex_count; ++vertex_i)
+    {
+        int16_t const *const v = model.vertex[vertex_i];
+        fprintf(out, "%s{%d, %d, %d},", vertex_i % 4 ? " " : "\n  ", v[0],
+                v[1], v[2]);
+    }
+    fprintf(out, "\n};\n");
+    fprintf(out, "uint8_t const __in_flash(\"%s\") %s_edge[%u][2] = {", name,
+            name, model.edge_count);
+    for (uint32_t edge_i = 0; edge_i < model.edge_count; ++edge_i)
+    {
+        fprintf(out, "%s{%u, %u},", edge_i % 8 ? " " : "\n  ",
+                model.edge[edge_i][0], model.edge[edge_i][1]);
+    }
+    fprintf(out, "\n};\n");
+    fprintf(out, "uint8_t const __in_flash(\"%s\") %s_face[%u][3] = {", name,
+            name, model.face_count);
+    for (uint32_t face_i = 0; face_i < model.face_count; ++face_i)
+    {
+        uint32_t const *const f = model.face[face_i];
+        fprintf(out, "%s{%u, %u, %u},", face_i % 6 ? " " : "\n  ", f[0], f[1],
+                f[2]);
+    }
+    fprintf(out, "\n};\n");
+    fprintf(out, "int16_t const __in_flash(\"%s\") %s_normal[%u][3] = {",
+            name, name, model.face_count);
+    for (uint32_t face_i = 0; face_i < model.face_count; ++face_i)
+    {
+        int16_t const *const n = model.normal[face_i];
+        fprintf(out, "%s{%d, %d, %d},", face_i % 4 ? " " : "\n  ", n[0], n[1],
+                n[2]);
+    }
+    fprintf(out, "\n};\n");
+    fprintf(out,
+            "mesh_st const %s = {\n"
+            "  %s_vertex, %u, %s_edge, %u,\n"
+            "  %s_face, %s_normal, %u,\n"
+            "  {%d, %d, %d}, %d,\n"
+            "};\n",
+            name, name, model.vertex_count, name, model.edge_count, name,
+            name, model.face_count, model.center[0], model.center[1],
+            model.center[2], model.radius);
+
+    printf("mesh_gen: %s, %u vertices, %u edges, %u faces\n", name,
+           model.vertex_count, model.edge_count, model.face_count);
+}
+
+int main(int const argc, char const *const argv[])
+{
+    if (argc < 3)
+    {
+        fprintf(stderr,
+                "usage: mesh_gen <output.h> <model.obj|model.ply>...\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE *const out = fopen(argv[1], "w");
+    if (!out)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    fprintf(out, "/* Generated by mesh_gen, do not edit. */\n");
+    for (int model_i = 2; model_i < argc; ++model_i)
+    {
+        model_path = argv[model_i];
+        FILE *const in = fopen(model_path, "r");
+        if (!in)
+        {
+            perror(model_path);
+            return EXIT_FAILURE;
+        }
+        memset(&model, 0, sizeof(model));
+        char const *const ext = strrchr(model_path, '.');
+        if (ext && strcmp(ext, ".ply") == 0)
+        {
+            model_ply_read(in);
+        }
+        else
+        {
+            model_obj_read(in);
+        }
+        fclose(in);
+
+        model_index();
+        if (model.face_count == 0)
+        {
+            model_fail("no faces");
+        }
+        model_edge_create();
+        model_normal_create();
+        model_sphere_create();
+        model_write(out);
+    }
+    fclose(out);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+/* Writes the lookup tables of the fixed-point plasma into a C header.
+ *
+ * Usage: plasma_gen <output.h>
+ *
+ * plasma_sin holds the sine over a full turn, plasma_dist the distance of
+ * every pixel from the top left corner, with the screen being 1 wide and 1
+ * high, as an angle. plasma_shade holds the color of v * PI over a full turn,
+ * truncated and wrapped like the float plasma. */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "plasma.h"
+
+#define SIN_LEN (1U << PLASMA_SIN_BITS)
+#define SHADE_LEN (1U << PLASMA_SHADE_BITS)
+
+int main(int const argc, char const *const argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: plasma_gen <output.h>\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE *const out = fopen(argv[1], "w");
+    if (!out)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    fprintf(out, "/* Generated by plasma_gen, do not edit. */\n");
+    fprintf(out, "int16_t const __in_flash(\"plasma_sin\") "
+                 "plasma_sin[%u] = {",
+            SIN_LEN);
+    for (uint32_t sin_i = 0; sin_i < SIN_LEN; ++sin_i)
+    {
+        double const angle = 2.0 * M_PI * sin_i / SIN_LEN;
+        fprintf(out, "%s%ld,", sin_i % 12 ? " " : "\n  ",
+                lround(sin(angle) * (1L << PLASMA_SIN_Q)));
+    }
+    fprintf(out, "\n};\n");
+
+    fprintf(out, "uint16_t const __in_flash(\"plasma_dist\") "
+                 "plasma_dist[%u][%u] = {",
+            PLASMA_DIST_H, PLASMA_DIST_W);
+    for (uint32_t _y = 0; _y < PLASMA_DIST_H; ++_y)
+    {
+        fprintf(out, "\n  {");
+        for (uint32_t _x = 0; _x < PLASMA_DIST_W; ++_x)
+        {
+            double const dy = (double)_y / (PLASMA_DIST_H - 1U);
+            double const dx = (double)_x / (PLASMA_DIST_W - 1U);
+            double const dist = sqrt(dx * dx + dy * dy);
+            fprintf(out, "%s%ld,", _x % 12 ? " " : "\n   ",
+                    lround(dist * 65536.0 / (2.0 * M_PI)));
+        }
+        fprintf(out, "\n  },");
+    }
+    fprintf(out, "\n};\n");
+
+    fprintf(out, "uint8_t const __in_flash(\"plasma_shade\") "
+                 "plasma_shade[%u] = {",
+            SHADE_LEN);
+    for (uint32_t shade_i = 0; shade_i < SHADE_LEN; ++shade_i)
+    {
+        double const angle = 2.0 * M_PI * shade_i / SHADE_LEN;
+        uint8_t const r = (uint8_t)(int)(sin(angle) * 64.0);
+        uint8_t const b = (uint8_t)(int)(cos(angle) * 64.0);
+        fprintf(out, "%s%u,", shade_i % 12 ? " " : "\n  ", (r + b) % 255);
+    }
+    fprintf(out, "\n};\n");
+    fclose(out);
+
+    printf("plasma_gen: %zu bytes of tables\n",
+           SIN_LEN * sizeof(int16_t) +
+               PLASMA_DIST_W * PLASMA_DIST_H * sizeof(uint16_t) + SHADE_LEN);
+    return EXIT_SUCCESS;
+}
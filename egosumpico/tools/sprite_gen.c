@@ -0,0 +1,231 @@
+/* Converts 8-bit grayscale images into run-length coded sprites and writes
+ * them into a C header, see `sprite.h` for the format.
+ *
+ * Usage: sprite_gen <output.h> <image.pgm>...
+ *
+ * Each image becomes a `sprite_st` named after its file, `data/bob.pgm` gives
+ * `sprite_bob`. Images are binary (P5) or plain (P2) PGM with a maxval of at
+ * most 255, gray level 0 is transparent. */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sprite.h"
+
+#define SPRITE_SIDE_MAX 255U
+
+static char const *image_path;
+static uint8_t image[SPRITE_SIDE_MAX][SPRITE_SIDE_MAX];
+static uint32_t image_w;
+static uint32_t image_h;
+
+static uint8_t data[SPRITE_SIDE_MAX * SPRITE_SIDE_MAX * 2U];
+static uint32_t data_len;
+static uint16_t row_offset[SPRITE_SIDE_MAX];
+
+static void image_fail(char const *const message)
+{
+    fprintf(stderr, "sprite_gen: %s: %s\n", image_path, message);
+    exit(EXIT_FAILURE);
+}
+
+/* Next number of the header or of a plain image, skipping comments. */
+static uint32_t pgm_number(FILE *const in)
+{
+    int ch = fgetc(in);
+    while (ch == '#' || isspace(ch))
+    {
+        if (ch == '#')
+        {
+            while (ch != '\n' && ch != EOF)
+            {
+                ch = fgetc(in);
+            }
+        }
+        ch = fgetc(in);
+    }
+    if (!isdigit(ch))
+    {
+        image_fail("bad PGM");
+    }
+    uint32_t number = 0;
+    while (isdigit(ch))
+    {
+        number = number * 10U + (uint32_t)(ch - '0');
+        ch = fgetc(in);
+    }
+    /* A single whitespace ends the number, in P5 the pixels follow it. */
+    return number;
+}
+
+static void image_read(FILE *const in)
+{
+    char magic[2];
+    if (fread(magic, 1, 2, in) != 2 || magic[0] != 'P' ||
+        (magic[1] != '2' && magic[1] != '5'))
+    {
+        image_fail("not a PGM file");
+    }
+    image_w = pgm_number(in);
+    image_h = pgm_number(in);
+    uint32_t const maxval = pgm_number(in);
+    if (image_w == 0 || image_h == 0 || image_w > SPRITE_SIDE_MAX ||
+        image_h > SPRITE_SIDE_MAX)
+    {
+        image_fail("sprites are 1 to 255 pixels wide and high");
+    }
+    if (maxval == 0 || maxval > 255U)
+    {
+        image_fail("only 8-bit images are supported");
+    }
+    for (uint32_t _y = 0; _y < image_h; ++_y)
+    {
+        for (uint32_t _x = 0; _x < image_w; ++_x)
+        {
+            if (magic[1] == '2')
+            {
+                image[_y][_x] = (uint8_t)pgm_number(in);
+            }
+            else
+            {
+                int const pixel = fgetc(in);
+                if (pixel == EOF)
+                {
+                    image_fail("file ends early");
+                }
+                image[_y][_x] = (uint8_t)pixel;
+            }
+        }
+    }
+}
+
+static void data_put(uint8_t const byte)
+{
+    data[data_len++] = byte;
+}
+
+static void image_encode()
+{
+    data_len = 0;
+    for (uint32_t _y = 0; _y < image_h; ++_y)
+    {
+        row_offset[_y] = (uint16_t)data_len;
+        uint32_t const run_count_at = data_len;
+        uint8_t run_count = 0;
+        data_put(0);
+
+        uint32_t _x = 0;
+        while (_x < image_w)
+        {
+            uint32_t const run_first = _x;
+            while (_x < image_w && image[_y][_x] == 0)
+            {
+                ++_x;
+            }
+            if (_x == image_w)
+            {
+                break;
+            }
+            uint32_t const opaque_first = _x;
+            while (_x < image_w && image[_y][_x] != 0)
+            {
+                ++_x;
+            }
+            data_put((uint8_t)(opaque_first - run_first));
+            data_put((uint8_t)(_x - opaque_first));
+            for (uint32_t pixel_x = opaque_first; pixel_x < _x; ++pixel_x)
+            {
+                data_put(image[_y][pixel_x]);
+            }
+            ++run_count;
+        }
+        data[run_count_at] = run_count;
+    }
+    if (data_len > UINT16_MAX)
+    {
+        image_fail("sprite too large");
+    }
+}
+
+/* `sprite_` followed by the file name without directory and extension. */
+static void image_name(char *const name, size_t const name_len)
+{
+    char const *base = strrchr(image_path, '/');
+    base = base ? base + 1 : image_path;
+    size_t len = snprintf(name, name_len, "sprite_%s", base);
+    char *const dot = strrchr(name, '.');
+    if (dot)
+    {
+        *dot = '\0';
+        len = (size_t)(dot - name);
+    }
+    for (size_t char_i = 0; char_i < len; ++char_i)
+    {
+        if (!isalnum((unsigned char)name[char_i]))
+        {
+            name[char_i] = '_';
+        }
+    }
+}
+
+static void image_write(FILE *const out)
+{
+    char name[128];
+    image_name(name, sizeof(name));
+
+    fprintf(out, "uint8_t const __in_flash(\"%s\") %s_data[%u] = {", name,
+            name, data_len);
+    for (uint32_t byte_i = 0; byte_i < data_len; ++byte_i)
+    {
+        fprintf(out, "%s0x%02x,", byte_i % 12 ? " " : "\n  ", data[byte_i]);
+    }
+    fprintf(out, "\n};\n");
+    fprintf(out, "uint16_t const __in_flash(\"%s\") %s_row[%u] = {", name,
+            name, image_h);
+    for (uint32_t _y = 0; _y < image_h; ++_y)
+    {
+        fprintf(out, "%s%u,", _y % 12 ? " " : "\n  ", row_offset[_y]);
+    }
+    fprintf(out, "\n};\n");
+    fprintf(out, "sprite_st const %s = {%u, %u, %s_row, %s_data};\n", name,
+            image_w, image_h, name, name);
+
+    printf("sprite_gen: %s, %ux%u in %u bytes\n", name, image_w, image_h,
+           data_len);
+}
+
+int main(int const argc, char const *const argv[])
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: sprite_gen <output.h> <image.pgm>...\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE *const out = fopen(argv[1], "w");
+    if (!out)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    fprintf(out, "/* Generated by sprite_gen, do not edit. */\n");
+    for (int image_i = 2; image_i < argc; ++image_i)
+    {
+        image_path = argv[image_i];
+        FILE *const in = fopen(image_path, "rb");
+        if (!in)
+        {
+            perror(image_path);
+            return EXIT_FAILURE;
+        }
+        image_read(in);
+        fclose(in);
+        image_encode();
+        image_write(out);
+    }
+    fclose(out);
+    return EXIT_SUCCESS;
+}